@@ -0,0 +1,94 @@
+#include <algorithm>
+#include <stdexcept>
+#include "aho_corasick.h"
+
+aho_corasick::aho_corasick(const std::vector<std::string> &patterns) : _patterns(patterns) {
+    std::fill(std::begin(_class), std::end(_class), 0);
+    _classes = 1;
+    for (const auto &p : _patterns) {
+        for (char c : p) {
+            auto &cls = _class[(unsigned char) c];
+            if (cls == 0) cls = (std::uint8_t) _classes++;
+        }
+    }
+    // 255 bytes in patterns plus the shared class would need 256 classes, which don't fit in a byte.
+    if (_classes > 255) {
+        for (std::size_t b = 0; b < 256; b++) {
+            _class[b] = (std::uint8_t) b;
+        }
+        _classes = 256;
+    }
+
+    // Trie, with missing edges as -1.
+    std::vector<std::int64_t> trie(_classes, -1);
+    std::vector<std::vector<std::uint32_t>> own(1);
+    std::size_t states = 1;
+    for (std::size_t id = 0; id < _patterns.size(); id++) {
+        if (_patterns[id].empty()) continue;
+        std::size_t st = 0;
+        for (char c : _patterns[id]) {
+            auto &edge = trie[st * _classes + _class[(unsigned char) c]];
+            if (edge < 0) {
+                edge = (std::int64_t) states++;
+                trie.resize(states * _classes, -1);
+                own.emplace_back();
+            }
+            st = (std::size_t) trie[st * _classes + _class[(unsigned char) c]];
+        }
+        own[st].push_back((std::uint32_t) id);
+    }
+    if (states * _classes >= MATCHES) throw std::length_error("too many patterns for aho_corasick");
+
+    // Breadth-first, so that a state's failure target is complete before the state itself.
+    std::vector<std::size_t> fail(states, 0);
+    std::vector<std::size_t> order;
+    order.reserve(states);
+    _next.assign(states * _classes, 0);
+    for (std::size_t c = 0; c < _classes; c++) {
+        if (trie[c] > 0) {
+            _next[c] = (std::uint32_t) trie[c];
+            order.push_back((std::size_t) trie[c]);
+        }
+    }
+    for (std::size_t k = 0; k < order.size(); k++) {
+        std::size_t st = order[k];
+        for (std::size_t c = 0; c < _classes; c++) {
+            std::int64_t child = trie[st * _classes + c];
+            if (child > 0) {
+                fail[(std::size_t) child] = _next[fail[st] * _classes + c];
+                _next[st * _classes + c] = (std::uint32_t) child;
+                order.push_back((std::size_t) child);
+            } else {
+                _next[st * _classes + c] = _next[fail[st] * _classes + c];
+            }
+        }
+    }
+
+    // Longest patterns first: the state's own, then those of its failure chain.
+    std::vector<std::vector<std::uint32_t>> all(states);
+    for (std::size_t st : order) {
+        all[st] = own[st];
+        const auto &inherited = all[fail[st]];
+        all[st].insert(all[st].end(), inherited.begin(), inherited.end());
+    }
+    _match_begin.assign(states + 1, 0);
+    for (std::size_t st = 0; st < states; st++) {
+        _match_begin[st] = (std::uint32_t) _matches.size();
+        _matches.insert(_matches.end(), all[st].begin(), all[st].end());
+    }
+    _match_begin[states] = (std::uint32_t) _matches.size();
+
+    for (auto &entry : _next) {
+        std::uint32_t target = entry;
+        entry = target * (std::uint32_t) _classes;
+        if (!all[target].empty()) entry |= MATCHES;
+    }
+}
+
+std::size_t aho_corasick::pattern_count() const {
+    return _patterns.size();
+}
+
+const std::string &aho_corasick::pattern(std::size_t id) const {
+    return _patterns[id];
+}
@@ -0,0 +1,78 @@
+#ifndef SEARCH_AHO_CORASICK_H
+#define SEARCH_AHO_CORASICK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Finds all occurrences of many patterns in one pass. The automaton is a dense table with a
+// row per state and a column per byte class: bytes that occur in no pattern share one class,
+// so a few hundred keywords over ASCII text take tens of columns instead of 256. Each entry
+// holds the target row premultiplied by the row width, with the top bit set when the target
+// state completes a pattern, so the scan loop does one load per input byte.
+struct aho_corasick {
+public:
+    // Patterns are identified by their index in `patterns`. Empty patterns never match.
+    explicit aho_corasick(const std::vector<std::string> &patterns);
+
+    std::size_t pattern_count() const;
+
+    const std::string &pattern(std::size_t id) const;
+
+    // Scan position carried from one buffer to the next, so matches that span buffers are found.
+    typedef std::uint32_t state;
+
+    static const state START = 0;
+
+    // Feeds data[0, size) to the automaton and calls on_match(pattern_id, match_offset) for every
+    // match ending in it. `offset` is the position of data[0] in the whole input. Matches come in
+    // order of their end; matches ending at the same byte come longest first. on_match returns
+    // whether to go on; scan returns false if it was stopped, leaving `s` after the byte that
+    // completed the last match.
+    template<typename F>
+    bool scan(const char *data, std::size_t size, std::size_t offset, state &s, F on_match) const;
+
+private:
+    static const std::uint32_t MATCHES = std::uint32_t(1) << 31;
+
+    std::vector<std::string> _patterns;
+    std::uint8_t _class[256];
+    std::size_t _classes;
+    std::vector<std::uint32_t> _next;
+    // Patterns recognized by each state, including those via failure links: for the state in
+    // row r, _matches[_match_begin[r], _match_begin[r + 1]).
+    std::vector<std::uint32_t> _match_begin;
+    std::vector<std::uint32_t> _matches;
+
+    template<typename F>
+    bool report(std::uint32_t row, std::size_t end, F &on_match) const;
+};
+
+template<typename F>
+bool aho_corasick::scan(const char *data, std::size_t size, std::size_t offset, state &s, F on_match) const {
+    const std::uint32_t *next = _next.data();
+    std::uint32_t row = s;
+    for (std::size_t i = 0; i < size; i++) {
+        std::uint32_t entry = next[row + _class[(unsigned char) data[i]]];
+        row = entry & ~MATCHES;
+        if ((entry & MATCHES) && !report(row, offset + i + 1, on_match)) {
+            s = row;
+            return false;
+        }
+    }
+    s = row;
+    return true;
+}
+
+template<typename F>
+bool aho_corasick::report(std::uint32_t row, std::size_t end, F &on_match) const {
+    std::size_t st = row / _classes;
+    for (std::uint32_t k = _match_begin[st]; k < _match_begin[st + 1]; k++) {
+        std::uint32_t id = _matches[k];
+        if (!on_match((std::size_t) id, end - _patterns[id].size())) return false;
+    }
+    return true;
+}
+
+#endif //SEARCH_AHO_CORASICK_H
@@ -0,0 +1,42 @@
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include "approximate.h"
+
+const std::uint64_t approximate_searcher::TOP;
+
+approximate_searcher::approximate_searcher(std::string pattern, std::size_t max_errors, metric_t metric)
+        : _pattern(std::move(pattern)), _max_errors(max_errors), _metric(metric) {
+    if (_max_errors >= _pattern.size()) {
+        throw std::invalid_argument("--max-errors must be less than the length of the word");
+    }
+    std::size_t m = _pattern.size();
+    _blocks = (m + 63) / 64;
+    _last = std::uint64_t(1) << ((m - 1) % 64);
+
+    _masks.assign(256 * _blocks, 0);
+    for (std::size_t i = 0; i < m; i++) {
+        _masks[(unsigned char) _pattern[i] * _blocks + i / 64] |= std::uint64_t(1) << (i % 64);
+    }
+    if (_metric == HAMMING) {
+        for (auto &mask : _masks) mask = ~mask;
+    }
+}
+
+std::size_t approximate_searcher::longest() const {
+    return _metric == HAMMING ? _pattern.size() : _pattern.size() + _max_errors;
+}
+
+approximate_searcher::state approximate_searcher::start() const {
+    state s;
+    if (_metric == HAMMING) {
+        // Nothing matched yet.
+        s.bits.assign((_max_errors + 1) * _blocks, ~std::uint64_t(0));
+    } else {
+        // Before any byte, prefix i is i deletions away.
+        s.bits.assign(2 * _blocks, 0);
+        std::fill(s.bits.begin(), s.bits.begin() + _blocks, ~std::uint64_t(0));
+        s.score = _pattern.size();
+    }
+    return s;
+}
@@ -0,0 +1,202 @@
+#ifndef SEARCH_APPROXIMATE_H
+#define SEARCH_APPROXIMATE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Finds where a pattern occurs with up to k errors, with bit-parallel automata that take a few
+// word operations per input byte. Mismatches alone (Hamming distance) use Shift-Or with a bit
+// vector per error count (Wu and Manber); edits use Myers' algorithm, which tracks the
+// differences between adjacent cells of a column of the edit distance table. Patterns of up to
+// 64 bytes fit in one word per vector; longer ones are split into 64-bit blocks.
+struct approximate_searcher {
+public:
+    enum metric_t : std::uint8_t {
+        HAMMING,    // substitutions only, so matches are as long as the pattern
+        EDIT        // substitutions, insertions and deletions
+    };
+
+    // Throws std::invalid_argument unless max_errors is smaller than the pattern's length; the
+    // pattern would match everywhere.
+    approximate_searcher(std::string pattern, std::size_t max_errors, metric_t metric);
+
+    // Length of the longest match: the bytes a search starting fresh has to see before an end.
+    std::size_t longest() const;
+
+    // Scan position carried from one buffer to the next.
+    struct state {
+        std::vector<std::uint64_t> bits;
+        std::size_t score = 0;
+    };
+
+    state start() const;
+
+    // Feeds data[0, size) to the automaton and calls on_match(end, errors) for every end of a
+    // match in it: `end` is one past the match's last byte, counted from the start of the whole
+    // input, which data[0] is `offset` bytes into, and `errors` is the fewest any match ending
+    // there has. on_match returns whether to go on; scan returns false if it was stopped.
+    template<typename F>
+    bool scan(const char *data, std::size_t size, std::size_t offset, state &s, F on_match) const;
+
+private:
+    static const std::uint64_t TOP = std::uint64_t(1) << 63;
+
+    std::string _pattern;
+    std::size_t _max_errors;
+    metric_t _metric;
+    std::size_t _blocks;
+    // Per byte, a word per block. Shift-Or masks have a 0 bit where the pattern holds the byte,
+    // Myers' masks a 1 bit.
+    std::vector<std::uint64_t> _masks;
+    // Bit of the last pattern byte in the last block.
+    std::uint64_t _last;
+
+    template<typename F>
+    bool scan_hamming(const char *data, std::size_t size, std::size_t offset, state &s, F &on_match) const;
+
+    template<typename F>
+    bool scan_hamming_blocks(const char *data, std::size_t size, std::size_t offset, state &s, F &on_match) const;
+
+    template<typename F>
+    bool scan_edit(const char *data, std::size_t size, std::size_t offset, state &s, F &on_match) const;
+
+    template<typename F>
+    bool scan_edit_blocks(const char *data, std::size_t size, std::size_t offset, state &s, F &on_match) const;
+};
+
+template<typename F>
+bool approximate_searcher::scan(const char *data, std::size_t size, std::size_t offset, state &s,
+                                F on_match) const {
+    if (_metric == HAMMING) {
+        return _blocks == 1 ? scan_hamming(data, size, offset, s, on_match)
+                            : scan_hamming_blocks(data, size, offset, s, on_match);
+    }
+    return _blocks == 1 ? scan_edit(data, size, offset, s, on_match)
+                        : scan_edit_blocks(data, size, offset, s, on_match);
+}
+
+// Bit i of r[d] is 0 when the last i + 1 bytes match the first i + 1 of the pattern with at most
+// d mismatches.
+template<typename F>
+bool approximate_searcher::scan_hamming(const char *data, std::size_t size, std::size_t offset, state &s,
+                                        F &on_match) const {
+    std::uint64_t *r = s.bits.data();
+    const std::uint64_t *masks = _masks.data();
+    std::size_t k = _max_errors;
+    for (std::size_t i = 0; i < size; i++) {
+        std::uint64_t mask = masks[(unsigned char) data[i]];
+        // Downwards, so that r[d - 1] still holds the previous position: a byte either matches
+        // or is one more mismatch.
+        for (std::size_t d = k; d > 0; d--) {
+            r[d] = ((r[d] << 1) | mask) & (r[d - 1] << 1);
+        }
+        r[0] = (r[0] << 1) | mask;
+        if (!(r[k] & _last)) {
+            std::size_t errors = 0;
+            while (r[errors] & _last) errors++;
+            if (!on_match(offset + i + 1, errors)) return false;
+        }
+    }
+    return true;
+}
+
+template<typename F>
+bool approximate_searcher::scan_hamming_blocks(const char *data, std::size_t size, std::size_t offset, state &s,
+                                               F &on_match) const {
+    std::uint64_t *r = s.bits.data();
+    std::size_t blocks = _blocks;
+    std::size_t k = _max_errors;
+    for (std::size_t i = 0; i < size; i++) {
+        const std::uint64_t *mask = _masks.data() + (unsigned char) data[i] * blocks;
+        // The same steps as with one word; each shift carries the top bit into the next block.
+        for (std::size_t d = k + 1; d-- > 0;) {
+            std::uint64_t *rd = r + d * blocks;
+            std::uint64_t *below = d > 0 ? rd - blocks : nullptr;
+            for (std::size_t b = blocks; b-- > 0;) {
+                std::uint64_t shifted = (rd[b] << 1) | (b > 0 ? rd[b - 1] >> 63 : 0);
+                std::uint64_t next = shifted | mask[b];
+                if (below) next &= (below[b] << 1) | (b > 0 ? below[b - 1] >> 63 : 0);
+                rd[b] = next;
+            }
+        }
+        if (!(r[(k + 1) * blocks - 1] & _last)) {
+            std::size_t errors = 0;
+            while (r[(errors + 1) * blocks - 1] & _last) errors++;
+            if (!on_match(offset + i + 1, errors)) return false;
+        }
+    }
+    return true;
+}
+
+// Bits of pv and mv are set where the edit distance of a pattern prefix to the best string
+// ending here grows or drops by one from the prefix a byte shorter; score is the distance of
+// the whole pattern. A match may start anywhere, so the row of the empty prefix stays 0.
+template<typename F>
+bool approximate_searcher::scan_edit(const char *data, std::size_t size, std::size_t offset, state &s,
+                                     F &on_match) const {
+    std::uint64_t pv = s.bits[0], mv = s.bits[1];
+    std::size_t score = s.score;
+    const std::uint64_t *masks = _masks.data();
+    bool going = true;
+    for (std::size_t i = 0; i < size && going; i++) {
+        std::uint64_t eq = masks[(unsigned char) data[i]];
+        std::uint64_t xv = eq | mv;
+        std::uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+        std::uint64_t ph = mv | ~(xh | pv);
+        std::uint64_t mh = pv & xh;
+        score += (ph & _last) != 0;
+        score -= (mh & _last) != 0;
+        ph <<= 1;
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+        if (score <= _max_errors) going = on_match(offset + i + 1, score);
+    }
+    s.bits[0] = pv;
+    s.bits[1] = mv;
+    s.score = score;
+    return going;
+}
+
+template<typename F>
+bool approximate_searcher::scan_edit_blocks(const char *data, std::size_t size, std::size_t offset, state &s,
+                                            F &on_match) const {
+    std::size_t blocks = _blocks;
+    std::uint64_t *pvs = s.bits.data(), *mvs = pvs + blocks;
+    for (std::size_t i = 0; i < size; i++) {
+        const std::uint64_t *eqs = _masks.data() + (unsigned char) data[i] * blocks;
+        // Each block passes the change along its bottom row to the block below.
+        int carry = 0;
+        for (std::size_t b = 0; b < blocks; b++) {
+            std::uint64_t pv = pvs[b], mv = mvs[b], eq = eqs[b];
+            std::uint64_t high = b + 1 == blocks ? _last : TOP;
+            std::uint64_t xv = eq | mv;
+            if (carry < 0) eq |= 1;
+            std::uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+            std::uint64_t ph = mv | ~(xh | pv);
+            std::uint64_t mh = pv & xh;
+            int out = (ph & high) ? 1 : (mh & high) ? -1 : 0;
+            ph <<= 1;
+            mh <<= 1;
+            if (carry < 0) {
+                mh |= 1;
+            } else if (carry > 0) {
+                ph |= 1;
+            }
+            pvs[b] = mh | ~(xv | ph);
+            mvs[b] = ph & xv;
+            carry = out;
+        }
+        if (carry > 0) {
+            s.score++;
+        } else if (carry < 0) {
+            s.score--;
+        }
+        if (s.score <= _max_errors && !on_match(offset + i + 1, s.score)) return false;
+    }
+    return true;
+}
+
+#endif //SEARCH_APPROXIMATE_H
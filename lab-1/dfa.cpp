@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <cstring>
+#include "dfa.h"
+
+const std::uint32_t lazy_dfa::UNKNOWN;
+
+namespace {
+    // Values of closure()'s `next` besides bytes.
+    const int UNDECIDED = -1;
+    const int INPUT_END = 256;
+}
+
+lazy_dfa::lazy_dfa(const regex &re)
+        : _re(re), _classes(re.classes()), _memory(0), _seen(re.program().size(), 0), _generation(0) {
+    memcpy(_class, re.byte_classes(), sizeof(_class));
+    clear();
+}
+
+void lazy_dfa::clear() {
+    _table.clear();
+    _sets.clear();
+    _preceding.clear();
+    _index.clear();
+    _memory = 0;
+    std::fill(std::begin(_start), std::end(_start), UNKNOWN);
+}
+
+lazy_dfa::preceding lazy_dfa::before(const char *data, std::size_t pos) {
+    if (pos == 0 || data[pos - 1] == '\n') return LINE_START;
+    return regex::word_byte((unsigned char) data[pos - 1]) ? WORD_BYTE : OTHER_BYTE;
+}
+
+lazy_dfa::state lazy_dfa::start(preceding p) {
+    if (_start[p] == UNKNOWN) {
+        std::vector<std::uint32_t> set;
+        closure({_re.start()}, p, UNDECIDED, set);
+        bool emptied;
+        // Assigned after add(), which may empty the cache and forget the other start states.
+        state s = add(set, p, emptied);
+        _start[p] = s;
+    }
+    return _start[p];
+}
+
+void lazy_dfa::closure(const std::vector<std::uint32_t> &roots, preceding p, int next,
+                       std::vector<std::uint32_t> &out) {
+    const auto &program = _re.program();
+    if (++_generation == 0) {
+        std::fill(_seen.begin(), _seen.end(), 0);
+        _generation = 1;
+    }
+    bool word_before = p == WORD_BYTE;
+    bool word_after = next >= 0 && next < INPUT_END && regex::word_byte((unsigned char) next);
+
+    out.clear();
+    _stack.assign(roots.begin(), roots.end());
+    while (!_stack.empty()) {
+        std::uint32_t at = _stack.back();
+        _stack.pop_back();
+        if (_seen[at] == _generation) continue;
+        _seen[at] = _generation;
+
+        const regex::instruction &ins = program[at];
+        switch (ins.kind) {
+            case regex::instruction::BYTES:
+            case regex::instruction::MATCH:
+                out.push_back(at);
+                break;
+            case regex::instruction::SPLIT:
+                _stack.push_back(ins.alt);
+                _stack.push_back(ins.next);
+                break;
+            case regex::instruction::LINE_START:
+                if (p == LINE_START) _stack.push_back(ins.next);
+                break;
+            case regex::instruction::LINE_END:
+            case regex::instruction::WORD_BOUNDARY:
+            case regex::instruction::NOT_WORD_BOUNDARY: {
+                // Decided by the next byte; kept until it is known.
+                if (next == UNDECIDED) {
+                    out.push_back(at);
+                    break;
+                }
+                bool holds = ins.kind == regex::instruction::LINE_END ? next == '\n' || next == INPUT_END
+                           : ins.kind == regex::instruction::WORD_BOUNDARY ? word_before != word_after
+                           : word_before == word_after;
+                if (holds) _stack.push_back(ins.next);
+                break;
+            }
+        }
+    }
+    std::sort(out.begin(), out.end());
+}
+
+lazy_dfa::state lazy_dfa::add(std::vector<std::uint32_t> &set, preceding p, bool &emptied) {
+    std::string key((const char *) set.data(), set.size() * sizeof(std::uint32_t));
+    key.push_back((char) p);
+    emptied = false;
+    auto found = _index.find(key);
+    if (found != _index.end()) return found->second;
+
+    // Table row, instruction list, and the key with the hash map's own overhead.
+    std::size_t cost = _classes * sizeof(std::uint32_t) + 2 * key.size() + 64;
+    if (_memory + cost > CACHE_BYTES && !_sets.empty()) {
+        clear();
+        emptied = true;
+    }
+    _memory += cost;
+
+    auto s = (state) (_sets.size() * _classes);
+    _sets.push_back(std::move(set));
+    _preceding.push_back(p);
+    _table.resize(_table.size() + _classes, UNKNOWN);
+    _index.emplace(std::move(key), s);
+    return s;
+}
+
+std::uint32_t lazy_dfa::transition(state s, std::size_t cls) {
+    const auto &program = _re.program();
+    const auto &sets = _re.sets();
+    unsigned char byte = _re.class_byte(cls);
+
+    // The byte settles the assertions about what follows, and a match found here ends before it.
+    closure(_sets[s / _classes], _preceding[s / _classes], byte, _here);
+    bool matched = false;
+    _roots.clear();
+    for (std::uint32_t at : _here) {
+        const regex::instruction &ins = program[at];
+        if (ins.kind == regex::instruction::MATCH) matched = true;
+        if (ins.kind == regex::instruction::BYTES && sets[ins.set].test(byte)) _roots.push_back(ins.next);
+    }
+    // Unanchored: a match may start at every byte.
+    _roots.push_back(_re.start());
+
+    std::vector<std::uint32_t> target;
+    preceding p = byte == '\n' ? LINE_START : regex::word_byte(byte) ? WORD_BYTE : OTHER_BYTE;
+    closure(_roots, p, UNDECIDED, target);
+    bool emptied;
+    state next = add(target, p, emptied);
+    std::uint32_t entry = next | (matched ? MATCHES : 0);
+    if (!emptied) _table[s + cls] = entry;
+    return entry;
+}
+
+bool lazy_dfa::matches_at_end(state s) {
+    closure(_sets[s / _classes], _preceding[s / _classes], INPUT_END, _here);
+    const auto &program = _re.program();
+    for (std::uint32_t at : _here) {
+        if (program[at].kind == regex::instruction::MATCH) return true;
+    }
+    return false;
+}
@@ -0,0 +1,113 @@
+#ifndef SEARCH_DFA_H
+#define SEARCH_DFA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "regex.h"
+
+// Runs a regex as a DFA whose states are sets of NFA instructions, built the first time a scan
+// reaches them. The table has the same layout as aho_corasick's: a row per state, a column per
+// byte class, premultiplied targets with the top bit flagging a match. The cache is bounded:
+// when it fills up it is emptied and refilled as the scan goes on, so memory stays fixed and a
+// byte never costs more than one step of the NFA. Every position where a match of the regex
+// ends is reported, matches being unanchored. A lazy_dfa is not thread-safe.
+struct lazy_dfa {
+public:
+    // Bytes of states and transitions the cache holds before it is emptied.
+    static const std::size_t CACHE_BYTES = std::size_t(8) << 20;
+
+    explicit lazy_dfa(const regex &re);
+
+    lazy_dfa(const lazy_dfa &) = delete;
+
+    lazy_dfa &operator=(const lazy_dfa &) = delete;
+
+    // Scan position. Emptying the cache invalidates states, so the only one to keep between
+    // calls is the one scan() leaves behind.
+    typedef std::uint32_t state;
+
+    // What precedes a position, as far as `^` and \b care.
+    enum preceding : std::uint8_t {
+        LINE_START,     // the start of the input or a newline
+        WORD_BYTE,
+        OTHER_BYTE
+    };
+
+    static preceding before(const char *data, std::size_t pos);
+
+    // State for starting a scan at a position preceded by `p`.
+    state start(preceding p);
+
+    // Feeds data[0, size) to the DFA and calls on_match(end) for every match ending right before
+    // one of these bytes; `offset` is the position of data[0] in the whole input. A match ending
+    // after the last byte shows up with the next byte, or from matches_at_end(). on_match returns
+    // whether to go on; scan returns false if it was stopped.
+    template<typename F>
+    bool scan(const char *data, std::size_t size, std::size_t offset, state &s, F on_match);
+
+    // Whether a match ends at the end of the input, s being the state after its last byte.
+    bool matches_at_end(state s);
+
+private:
+    static const std::uint32_t MATCHES = std::uint32_t(1) << 31;
+    static const std::uint32_t UNKNOWN = ~std::uint32_t(0);
+
+    const regex &_re;
+    std::uint8_t _class[256];
+    std::size_t _classes;
+    std::vector<std::uint32_t> _table;
+    // Per state: its instructions that consume a byte, match or wait for the next byte, sorted,
+    // and what preceded it.
+    std::vector<std::vector<std::uint32_t>> _sets;
+    std::vector<preceding> _preceding;
+    std::unordered_map<std::string, state> _index;
+    std::size_t _memory;
+    state _start[3];
+    // Scratch space for transitions and closures.
+    std::vector<std::uint32_t> _here;
+    std::vector<std::uint32_t> _roots;
+    std::vector<std::uint32_t> _stack;
+    std::vector<std::uint32_t> _seen;
+    std::uint32_t _generation;
+
+    // Computes the transition from s on a byte of class cls and caches it, unless the cache had
+    // to be emptied for the target. Returns the table entry.
+    std::uint32_t transition(state s, std::size_t cls);
+
+    // Collects the instructions reachable from roots without consuming a byte into out. `next`
+    // is the byte that follows, INPUT_END, or UNDECIDED to keep the assertions about it for later.
+    void closure(const std::vector<std::uint32_t> &roots, preceding p, int next, std::vector<std::uint32_t> &out);
+
+    state add(std::vector<std::uint32_t> &set, preceding p, bool &emptied);
+
+    void clear();
+};
+
+template<typename F>
+bool lazy_dfa::scan(const char *data, std::size_t size, std::size_t offset, state &s, F on_match) {
+    const std::uint32_t *table = _table.data();
+    std::uint32_t row = s;
+    for (std::size_t i = 0; i < size; i++) {
+        std::size_t cls = _class[(unsigned char) data[i]];
+        std::uint32_t entry = table[row + cls];
+        // UNKNOWN has the match bit set as well, so known transitions without a match take one branch.
+        if (entry & MATCHES) {
+            if (entry == UNKNOWN) {
+                entry = transition(row, cls);
+                table = _table.data();
+            }
+            if ((entry & MATCHES) && !on_match(offset + i)) {
+                s = entry & ~MATCHES;
+                return false;
+            }
+        }
+        row = entry & ~MATCHES;
+    }
+    s = row;
+    return true;
+}
+
+#endif //SEARCH_DFA_H
@@ -0,0 +1,177 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <system_error>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "input.h"
+
+namespace {
+    [[noreturn]] void throw_errno(int error, const std::string &what) {
+        throw std::system_error(error, std::generic_category(), what);
+    }
+
+    // Whether a read() on fd would return without waiting.
+    bool readable_now(int fd) {
+        pollfd p{fd, POLLIN, 0};
+        return poll(&p, 1, 0) > 0;
+    }
+}
+
+input_file::input_file(const char *path) : _fd(0), _owned(false) {
+    if (strcmp(path, "-") == 0) return;
+    _fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (_fd < 0) throw_errno(errno, path);
+    _owned = true;
+}
+
+input_file::input_file(int fd) : _fd(fd), _owned(true) {}
+
+input_file::~input_file() {
+    if (_owned) close(_fd);
+}
+
+int input_file::fd() const {
+    return _fd;
+}
+
+bool input_file::mappable() const {
+    struct stat st;
+    return fstat(_fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0;
+}
+
+mapped_file::mapped_file(const input_file &file) : _mapping(nullptr), _size(0) {
+    struct stat st;
+    if (fstat(file.fd(), &st) != 0) throw_errno(errno, "stat");
+    void *mapping = mmap(nullptr, (std::size_t) st.st_size, PROT_READ, MAP_PRIVATE, file.fd(), 0);
+    if (mapping == MAP_FAILED) throw_errno(errno, "mmap");
+    // The scan reads front to back once: ask for aggressive readahead.
+    madvise(mapping, (std::size_t) st.st_size, MADV_SEQUENTIAL);
+    _mapping = mapping;
+    _size = (std::size_t) st.st_size;
+}
+
+mapped_file::~mapped_file() {
+    munmap(_mapping, _size);
+}
+
+const char *mapped_file::data() const {
+    return (const char *) _mapping;
+}
+
+std::size_t mapped_file::size() const {
+    return _size;
+}
+
+stream_reader::stream_reader(int fd, std::size_t overlap)
+        : _fd(fd), _overlap(overlap), _blocks(BLOCKS), _stopping(false), _current(BLOCKS), _offset(0), _carried(0) {
+    for (auto &b : _blocks) {
+        b.bytes.resize(_overlap + BLOCK_SIZE);
+    }
+    if (pipe2(_wake, O_CLOEXEC) != 0) throw_errno(errno, "pipe");
+    _reader = std::thread([this] { read_blocks(); });
+}
+
+stream_reader::~stream_reader() {
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        _stopping = true;
+    }
+    _changed.notify_all();
+    char byte = 0;
+    while (write(_wake[1], &byte, 1) < 0 && errno == EINTR) {
+    }
+    _reader.join();
+    close(_wake[0]);
+    close(_wake[1]);
+}
+
+bool stream_reader::wait_for_input() {
+    pollfd fds[2] = {{_fd, POLLIN, 0}, {_wake[0], POLLIN, 0}};
+    while (poll(fds, 2, -1) < 0) {
+        if (errno != EINTR) return true;
+    }
+    return fds[1].revents == 0;
+}
+
+void stream_reader::read_blocks() {
+    for (std::size_t k = 0;; k = (k + 1) % _blocks.size()) {
+        block &b = _blocks[k];
+        {
+            std::unique_lock<std::mutex> guard(_lock);
+            _changed.wait(guard, [&] { return _stopping || !b.filled; });
+            if (_stopping) return;
+        }
+
+        // Short reads are normal on pipes: keep reading until the block is full or the input
+        // has nothing more for now, so a slow writer still sees its matches promptly.
+        std::size_t length = 0;
+        bool last = false;
+        int error = 0;
+        while (length < BLOCK_SIZE) {
+            if (!wait_for_input()) return;
+            ssize_t got = read(_fd, b.bytes.data() + _overlap + length, BLOCK_SIZE - length);
+            if (got < 0) {
+                if (errno == EINTR) continue;
+                error = errno;
+                last = true;
+                break;
+            }
+            if (got == 0) {
+                last = true;
+                break;
+            }
+            length += (std::size_t) got;
+            if (!readable_now(_fd)) break;
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(_lock);
+            b.length = length;
+            b.last = last;
+            b.error = error;
+            b.filled = true;
+        }
+        _changed.notify_all();
+        if (last) return;
+    }
+}
+
+bool stream_reader::next(const char *&data, std::size_t &size, std::size_t &offset) {
+    std::size_t k = _current == _blocks.size() ? 0 : (_current + 1) % _blocks.size();
+    if (_current != _blocks.size() && _blocks[_current].last) return false;
+
+    block &b = _blocks[k];
+    {
+        std::unique_lock<std::mutex> guard(_lock);
+        _changed.wait(guard, [&] { return b.filled; });
+    }
+    if (b.error) throw_errno(b.error, "read");
+
+    // Carry the end of the previous input into the overlap area, then hand the previous block back.
+    std::size_t carry = 0;
+    if (_current != _blocks.size()) {
+        block &prev = _blocks[_current];
+        std::size_t available = _carried + prev.length;
+        carry = std::min(_overlap, available);
+        memcpy(b.bytes.data() + _overlap - carry, prev.bytes.data() + _overlap + prev.length - carry, carry);
+        _offset += prev.length;
+        // From here on the reader may refill prev.
+        {
+            std::lock_guard<std::mutex> guard(_lock);
+            prev.filled = false;
+        }
+        _changed.notify_all();
+    }
+
+    _current = k;
+    _carried = carry;
+    data = b.bytes.data() + _overlap - carry;
+    size = carry + b.length;
+    offset = _offset - carry;
+    return true;
+}
@@ -0,0 +1,111 @@
+#ifndef SEARCH_INPUT_H
+#define SEARCH_INPUT_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Open file, closed on destruction. The path "-" stands for standard input, which is left open.
+struct input_file {
+public:
+    // Throws std::system_error if the file can't be opened.
+    explicit input_file(const char *path);
+
+    // Takes ownership of an open descriptor.
+    explicit input_file(int fd);
+
+    input_file(const input_file &) = delete;
+
+    input_file &operator=(const input_file &) = delete;
+
+    ~input_file();
+
+    int fd() const;
+
+    // Whether the file can be mapped: a non-empty regular file.
+    bool mappable() const;
+
+private:
+    int _fd;
+    bool _owned;
+};
+
+// Whole contents of a regular file, mapped read-only.
+struct mapped_file {
+public:
+    // Throws std::system_error if the file can't be mapped.
+    explicit mapped_file(const input_file &file);
+
+    mapped_file(const mapped_file &) = delete;
+
+    mapped_file &operator=(const mapped_file &) = delete;
+
+    ~mapped_file();
+
+    const char *data() const;
+
+    std::size_t size() const;
+
+private:
+    void *_mapping;
+    std::size_t _size;
+};
+
+// Reads a pipe, socket or any other file front to back on a background thread, into a ring of
+// blocks, so that reading overlaps with searching the previous block. Every block is preceded
+// by the last `overlap` bytes of the input before it, so a pattern of overlap + 1 bytes that
+// spans blocks is seen whole in the later one.
+struct stream_reader {
+public:
+    static const std::size_t BLOCK_SIZE = std::size_t(4) << 20;
+    static const std::size_t BLOCKS = 3;
+
+    stream_reader(int fd, std::size_t overlap);
+
+    stream_reader(const stream_reader &) = delete;
+
+    stream_reader &operator=(const stream_reader &) = delete;
+
+    // Stops reading, even if the input has nothing to read right now.
+    ~stream_reader();
+
+    // Points data at the next block, including the overlap in front of it, and offset at the
+    // position of data[0] in the input. The previous block is released. Returns false at the
+    // end of the input and throws std::system_error if reading failed.
+    bool next(const char *&data, std::size_t &size, std::size_t &offset);
+
+private:
+    struct block {
+        std::vector<char> bytes;
+        // Input bytes in the block, after the overlap area.
+        std::size_t length = 0;
+        bool filled = false;
+        bool last = false;
+        int error = 0;
+    };
+
+    int _fd;
+    std::size_t _overlap;
+    std::vector<block> _blocks;
+    std::mutex _lock;
+    std::condition_variable _changed;
+    bool _stopping;
+    // Written to on destruction, to wake the reader waiting for input.
+    int _wake[2];
+    // Block the consumer holds, or _blocks.size() before the first call to next().
+    std::size_t _current;
+    std::size_t _offset;
+    std::size_t _carried;
+    std::thread _reader;
+
+    void read_blocks();
+
+    // Waits until the input can be read without blocking; false if the reader should stop instead.
+    bool wait_for_input();
+};
+
+#endif //SEARCH_INPUT_H
@@ -1,44 +1,117 @@
-#include <iostream>
-#include <algorithm>
+#include <cstdio>
+#include <exception>
+#include <stdexcept>
 #include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "input.h"
+#include "matcher.h"
+#include "options.h"
+#include "output.h"
+#include "parallel_search.h"
+#include "suffix_index.h"
+#include "thread_pool.h"
+#include "tree_search.h"
 
-void print_all_occurrence(const std::string &s, const std::string &sub, size_t offset) {
-    size_t pos = s.find(sub, 0);
-    while (pos != std::string::npos) {
-        printf("%zu\n", pos + offset);
-        pos = s.find(sub, pos + 1);
+// Searches input that can't be mapped as it arrives.
+void search_stream(const matcher &m, int fd, match_writer &writer) {
+    std::vector<match> matches;
+    matcher::stream_state state;
+    stream_reader reader(fd, m.overlap());
+    const char *data;
+    size_t size, offset, end = 0;
+    while (writer.remaining() > 0 && reader.next(data, size, offset)) {
+        matches.clear();
+        m.find_next(data, size, offset, state, matches, writer.remaining());
+        if (!writer.add(matches)) return;
+        end = offset + size;
     }
+    matches.clear();
+    m.finish_stream(state, end, matches, writer.remaining());
+    writer.add(matches);
 }
 
-int main(int argc, char *argv[]) {
-    if (argc < 3) {
-        printf("Wrong number of arguments: %d got, 3 expected", argc);
-        return 1;
+void search_file(const matcher &m, const options &opts, match_writer &writer) {
+    input_file in(opts.paths[0].c_str());
+    if (!in.mappable()) {
+        search_stream(m, in.fd(), writer);
+        return;
     }
 
-    auto word = std::string(argv[argc - 1]);
-    auto file_name = argv[1];
-
-    const size_t BUF_SIZE = std::max((size_t) 100, word.length());
-
-    FILE *file = fopen(file_name, "r");
-    char buf[BUF_SIZE];
-
-    std::string cur_str, prev_str;
+    mapped_file file(in);
+    if (!opts.multi_pattern && !opts.regex && !opts.approximate) {
+        if (auto index = suffix_index::open(opts.paths[0], in, file)) {
+            if (opts.count_only) {
+                writer.add_count(index->count(opts.patterns[0]));
+            } else {
+                std::vector<match> matches;
+                index->find(opts.patterns[0], matches, writer.remaining());
+                writer.add(matches);
+            }
+            return;
+        }
+    }
 
-    auto read_cnt = BUF_SIZE;
-    for (size_t i = 0; read_cnt == BUF_SIZE; ++i) {
-        read_cnt = fread(buf, sizeof(char), BUF_SIZE, file);
-        cur_str = std::string(buf, read_cnt);
+    const char *data = file.data();
+    size_t size = file.size();
+    if (opts.threads > 1 && size >= 2 * CHUNK_SIZE && m.splittable()) {
+        thread_pool pool(opts.threads);
+        size_t max = opts.max_matches;
+        search_in_chunks(size, CHUNK_SIZE, pool, [&m, data, size, max](size_t begin, size_t end, std::vector<match> &out) {
+            m.find(data, size, begin, end, out, max);
+        }, [&writer](const std::vector<match> &matches) {
+            return writer.add(matches);
+        });
+    } else {
+        std::vector<match> matches;
+        m.find(data, size, 0, size, matches, writer.remaining());
+        writer.add(matches);
+    }
+}
 
-        auto overlap = prev_str.substr(std::max(prev_str.length(), word.length()) - word.length()) +
-                       cur_str.substr(0, word.length() - 1);
+bool is_directory(const std::string &path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
 
-        print_all_occurrence(overlap, word, i * BUF_SIZE - word.length());
-        print_all_occurrence(cur_str, word, i * BUF_SIZE);
+int main(int argc, char *argv[]) {
+    options opts;
+    try {
+        opts = parse_options(argc, argv);
+    } catch (const std::invalid_argument &e) {
+        printf("%s\n", e.what());
+        return 1;
+    }
 
-        prev_str = cur_str;
+    try {
+        if (opts.build_index) {
+            for (const auto &path : opts.paths) {
+                suffix_index::build(path, opts.with_lcp);
+            }
+            return 0;
+        }
+        matcher m(opts);
+        output_buffer out(STDOUT_FILENO);
+        if (opts.paths.size() > 1 || is_directory(opts.paths[0])) {
+            if (opts.binary) throw std::invalid_argument("--binary needs a single input");
+            thread_pool pool(opts.threads);
+            tree_search tree(m, opts, pool, out);
+            for (const auto &path : opts.paths) {
+                tree.add(path);
+            }
+            bool ok = tree.wait();
+            out.flush();
+            return ok ? 0 : 1;
+        }
+        match_writer writer(opts, m.multi_pattern(), out);
+        search_file(m, opts, writer);
+        writer.finish();
+        out.flush();
+    } catch (const std::exception &e) {
+        fprintf(stderr, "%s\n", e.what());
+        return 1;
     }
 
     return 0;
-}
\ No newline at end of file
+}
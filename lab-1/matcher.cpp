@@ -0,0 +1,304 @@
+#include <algorithm>
+#include <cstring>
+#include "matcher.h"
+
+namespace {
+    // Position after the last newline in data[floor, pos), or floor if there is none.
+    std::size_t line_start(const char *data, std::size_t floor, std::size_t pos) {
+        auto *newline = (const char *) memrchr(data + floor, '\n', pos - floor);
+        return newline ? (std::size_t) (newline - data) + 1 : floor;
+    }
+
+    // Position of the first newline in data[pos, size), or size if there is none.
+    std::size_t line_end(const char *data, std::size_t pos, std::size_t size) {
+        auto *newline = (const char *) memchr(data + pos, '\n', size - pos);
+        return newline ? (std::size_t) (newline - data) : size;
+    }
+}
+
+matcher::matcher(const options &opts) : _longest(0), _word_shift(0) {
+    for (const auto &p : opts.patterns) {
+        _longest = std::max(_longest, p.size());
+    }
+    if (opts.multi_pattern) {
+        _automaton.reset(new aho_corasick(opts.patterns));
+    } else if (opts.regex) {
+        _regex.reset(new regex(opts.patterns[0]));
+        if (_regex->plain_string()) {
+            // Searched like a word, reporting where matches end.
+            _word.reset(new searcher(_regex->required()));
+            _longest = _word_shift = _regex->required().size();
+            _regex.reset();
+        } else if (!_regex->matches_newline() && !_regex->required().empty()) {
+            _prefilter.reset(new searcher(_regex->required()));
+        }
+    } else if (opts.approximate) {
+        _approximate.reset(new approximate_searcher(opts.patterns[0], opts.max_errors,
+                                                    opts.hamming ? approximate_searcher::HAMMING
+                                                                 : approximate_searcher::EDIT));
+        const std::string &word = opts.patterns[0];
+        std::size_t pieces = opts.max_errors + 1;
+        if (word.size() / pieces >= MIN_PIECE) {
+            for (std::size_t k = 0; k < pieces; k++) {
+                std::size_t from = word.size() * k / pieces, to = word.size() * (k + 1) / pieces;
+                _pieces.emplace_back(word.substr(from, to - from));
+                _piece_offsets.push_back(from);
+            }
+        }
+    } else {
+        _word.reset(new searcher(opts.patterns[0]));
+    }
+}
+
+bool matcher::multi_pattern() const {
+    return _automaton != nullptr;
+}
+
+bool matcher::approximate() const {
+    return _approximate != nullptr;
+}
+
+bool matcher::splittable() const {
+    return !_regex || !_regex->matches_newline() || _regex->max_length() != SIZE_MAX;
+}
+
+void matcher::find(const char *data, std::size_t size, std::size_t begin, std::size_t end,
+                   std::vector<match> &out, std::size_t max_matches) const {
+    if (out.size() >= max_matches) return;
+    if (_word) {
+        // The last match may run up to word.length() - 1 bytes past end.
+        std::size_t limit = std::min(size, end + _longest - 1);
+        for (std::size_t pos = _word->find(data, limit, begin); pos < end; pos = _word->find(data, limit, pos + 1)) {
+            out.push_back(match{0, pos + _word_shift});
+            if (out.size() >= max_matches) break;
+        }
+        return;
+    }
+    if (_regex) {
+        find_regex(data, size, begin, end, out, max_matches);
+        return;
+    }
+    if (_approximate) {
+        find_approximate(data, begin, end, out, max_matches);
+        return;
+    }
+
+    // The automaton starts fresh far enough before begin to see the longest pattern.
+    std::size_t from = begin > _longest ? begin - _longest : 0;
+    aho_corasick::state state = aho_corasick::START;
+    _automaton->scan(data + from, end - from, from, state, [&](std::size_t id, std::size_t pos) {
+        if (pos + _automaton->pattern(id).size() > begin) out.push_back(match{id, pos});
+        return out.size() < max_matches;
+    });
+}
+
+std::size_t matcher::overlap() const {
+    if (_approximate) return _approximate->longest();
+    return _word ? _longest - 1 : 0;
+}
+
+void matcher::find_next(const char *data, std::size_t size, std::size_t offset, stream_state &state,
+                        std::vector<match> &out, std::size_t max_matches) const {
+    if (out.size() >= max_matches) return;
+    if (_regex) {
+        find_next_regex(data, size, offset, state, out, max_matches);
+        return;
+    }
+    if (_approximate) {
+        // Matches ending in the carried bytes were found with the last block.
+        std::size_t first = out.size();
+        find(data, size, std::min(state.searched - offset, size), size, out, max_matches);
+        for (std::size_t k = first; k < out.size(); k++) {
+            out[k].offset += offset;
+        }
+        state.searched = offset + size;
+        return;
+    }
+    if (_automaton) {
+        _automaton->scan(data, size, offset, state.automaton, [&](std::size_t id, std::size_t pos) {
+            out.push_back(match{id, pos});
+            return out.size() < max_matches;
+        });
+        return;
+    }
+
+    // A match needs a byte past the carried ones, so none is found twice.
+    std::size_t first = out.size();
+    find(data, size, 0, size, out, max_matches);
+    for (std::size_t k = first; k < out.size(); k++) {
+        out[k].offset += offset;
+    }
+}
+
+void matcher::finish_stream(stream_state &state, std::size_t end, std::vector<match> &out,
+                            std::size_t max_matches) const {
+    if (!_regex || !state.dfa || out.size() >= max_matches) return;
+    // With the prefilter, the state is only kept up to date within an unfinished line.
+    if (_prefilter && !state.within_line) return;
+    if (state.dfa->matches_at_end(state.regex_state)) out.push_back(match{0, end});
+}
+
+void matcher::find_regex(const char *data, std::size_t size, std::size_t begin, std::size_t end,
+                         std::vector<match> &out, std::size_t max_matches) const {
+    // No match ending in the range starts before its line, or further back than the longest match.
+    std::size_t from = 0;
+    if (!_regex->matches_newline()) {
+        from = line_start(data, 0, begin);
+    } else if (_regex->max_length() < begin) {
+        from = begin - _regex->max_length();
+    }
+    // A match ending at `end` shows up with the byte there.
+    std::size_t to = std::min(size, end + 1);
+
+    auto dfa = take_dfa();
+    if (!_prefilter) {
+        lazy_dfa::state s = dfa->start(lazy_dfa::before(data, from));
+        if (scan_regex(*dfa, s, data + from, to - from, from, begin + 1, out, max_matches) && end == size &&
+            dfa->matches_at_end(s)) {
+            out.push_back(match{0, size});
+        }
+        return_dfa(std::move(dfa));
+        return;
+    }
+
+    // Only lines containing the literal can hold a match. The literal is part of the match, so
+    // it ends by `end` too.
+    std::size_t pos = from;
+    while (pos < to) {
+        std::size_t hit = _prefilter->find(data, end, pos);
+        if (hit == end) break;
+        std::size_t line = line_start(data, pos, hit);
+        std::size_t stop = std::min(line_end(data, hit, size) + 1, to);
+        lazy_dfa::state s = dfa->start(lazy_dfa::LINE_START);
+        if (!scan_regex(*dfa, s, data + line, stop - line, line, begin + 1, out, max_matches)) break;
+        if (stop == size && end == size && dfa->matches_at_end(s)) out.push_back(match{0, size});
+        pos = stop;
+    }
+    return_dfa(std::move(dfa));
+}
+
+void matcher::find_next_regex(const char *data, std::size_t size, std::size_t offset, stream_state &state,
+                              std::vector<match> &out, std::size_t max_matches) const {
+    if (!state.dfa) {
+        state.dfa.reset(new lazy_dfa(*_regex));
+        state.regex_state = state.dfa->start(lazy_dfa::LINE_START);
+    }
+    lazy_dfa &dfa = *state.dfa;
+    if (!_prefilter) {
+        scan_regex(dfa, state.regex_state, data, size, offset, 0, out, max_matches);
+        return;
+    }
+    if (size == 0) return;
+
+    std::size_t pos = 0;
+    if (state.within_line) {
+        // The line the last block ended in may hold the rest of a match.
+        pos = std::min(line_end(data, 0, size) + 1, size);
+        if (!scan_regex(dfa, state.regex_state, data, pos, offset, 0, out, max_matches)) return;
+    }
+    while (pos < size) {
+        // Without another hit only an unfinished last line is run, for the next block.
+        std::size_t hit = _prefilter->find(data, size, pos);
+        std::size_t line = line_start(data, pos, hit);
+        std::size_t stop = hit == size ? size : std::min(line_end(data, hit, size) + 1, size);
+        if (line == stop) break;
+        state.regex_state = dfa.start(lazy_dfa::LINE_START);
+        if (!scan_regex(dfa, state.regex_state, data + line, stop - line, offset + line, 0, out, max_matches)) {
+            return;
+        }
+        pos = stop;
+    }
+    state.within_line = data[size - 1] != '\n';
+}
+
+bool matcher::scan_regex(lazy_dfa &dfa, lazy_dfa::state &s, const char *data, std::size_t size, std::size_t offset,
+                         std::size_t first, std::vector<match> &out, std::size_t max_matches) const {
+    dfa.scan(data, size, offset, s, [&](std::size_t pos) {
+        if (pos >= first) out.push_back(match{0, pos});
+        return out.size() < max_matches;
+    });
+    return out.size() < max_matches;
+}
+
+void matcher::find_approximate(const char *data, std::size_t begin, std::size_t end, std::vector<match> &out,
+                               std::size_t max_matches) const {
+    // A match is `longest` bytes at most, so it is seen whole by starting that far back.
+    std::size_t longest = _approximate->longest();
+    if (_pieces.empty()) {
+        scan_approximate(data, begin > longest ? begin - longest : 0, end, begin + 1, out, max_matches);
+        return;
+    }
+
+    // A piece found at h, which is o bytes into the word, is part of matches ending in
+    // [h - o + m - slack, h - o + m + slack], slack being max_errors with edits and 0 without.
+    // Ends past the piece itself, and in the range, are the ones to look at.
+    std::size_t m = _longest, slack = longest - m;
+    std::vector<std::size_t> hits(_pieces.size());
+    for (std::size_t p = 0; p < _pieces.size(); p++) {
+        std::size_t reach = _piece_offsets[p] + 1 + begin;
+        hits[p] = _pieces[p].find(data, end, reach > m + slack ? reach - m - slack : 0);
+    }
+    auto lowest_end = [&](std::size_t p) {
+        std::size_t h = hits[p], o = _piece_offsets[p];
+        std::size_t low = h + _pieces[p].pattern().size();
+        return h + m > o + slack ? std::max(low, h + m - o - slack) : low;
+    };
+
+    // Ends close enough together are scanned in one go rather than starting over.
+    std::size_t window_begin = 0, window_end = 0;
+    bool open = false;
+    while (true) {
+        std::size_t next = _pieces.size();
+        for (std::size_t p = 0; p < _pieces.size(); p++) {
+            if (hits[p] < end && (next == _pieces.size() || lowest_end(p) < lowest_end(next))) next = p;
+        }
+        if (next == _pieces.size()) break;
+        std::size_t low = std::max(lowest_end(next), begin + 1);
+        std::size_t high = std::min(hits[next] + m + slack - _piece_offsets[next], end);
+        hits[next] = _pieces[next].find(data, end, hits[next] + 1);
+        if (low > high) continue;
+
+        if (open && low <= window_end + longest) {
+            window_end = std::max(window_end, high);
+            continue;
+        }
+        if (open && !scan_approximate(data, window_begin > longest ? window_begin - longest : 0, window_end,
+                                      window_begin, out, max_matches)) {
+            return;
+        }
+        window_begin = low;
+        window_end = high;
+        open = true;
+    }
+    if (open) {
+        scan_approximate(data, window_begin > longest ? window_begin - longest : 0, window_end, window_begin, out,
+                         max_matches);
+    }
+}
+
+bool matcher::scan_approximate(const char *data, std::size_t from, std::size_t to, std::size_t first,
+                               std::vector<match> &out, std::size_t max_matches) const {
+    auto state = _approximate->start();
+    _approximate->scan(data + from, to - from, from, state, [&](std::size_t pos, std::size_t errors) {
+        if (pos >= first) out.push_back(match{0, pos, errors});
+        return out.size() < max_matches;
+    });
+    return out.size() < max_matches;
+}
+
+std::unique_ptr<lazy_dfa> matcher::take_dfa() const {
+    {
+        std::lock_guard<std::mutex> guard(_dfa_lock);
+        if (!_idle_dfas.empty()) {
+            auto dfa = std::move(_idle_dfas.back());
+            _idle_dfas.pop_back();
+            return dfa;
+        }
+    }
+    return std::unique_ptr<lazy_dfa>(new lazy_dfa(*_regex));
+}
+
+void matcher::return_dfa(std::unique_ptr<lazy_dfa> dfa) const {
+    std::lock_guard<std::mutex> guard(_dfa_lock);
+    _idle_dfas.push_back(std::move(dfa));
+}
@@ -0,0 +1,119 @@
+#ifndef SEARCH_MATCHER_H
+#define SEARCH_MATCHER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "aho_corasick.h"
+#include "approximate.h"
+#include "dfa.h"
+#include "options.h"
+#include "regex.h"
+#include "search.h"
+
+struct match {
+    // Index of the pattern in multi-pattern mode, 0 otherwise.
+    std::size_t pattern;
+    // Where the match starts, or where it ends (one past its last byte) for a regex or an
+    // approximate match.
+    std::size_t offset;
+    // Errors of an approximate match.
+    std::size_t errors = 0;
+};
+
+// What the command line asked to look for, searched in a range of a buffer or in a stream.
+struct matcher {
+public:
+    // Shortest piece of the word worth searching for before running the approximate automaton.
+    static const std::size_t MIN_PIECE = 3;
+
+    explicit matcher(const options &opts);
+
+    bool multi_pattern() const;
+
+    bool approximate() const;
+
+    // Whether find() can search the ranges of a partition separately without rescanning most of
+    // the buffer for each. Only a regex that matches across lines and has no length limit can't.
+    bool splittable() const;
+
+    // Appends the matches that belong to [begin, end) of data[0, size), in output order. Every
+    // match belongs to exactly one range of a partition of the buffer: a word to the range it
+    // starts in, a multi-pattern or regex match to the range it ends in (the order the automata
+    // find them). Stops once `out` holds max_matches matches.
+    void find(const char *data, std::size_t size, std::size_t begin, std::size_t end, std::vector<match> &out,
+              std::size_t max_matches = SIZE_MAX) const;
+
+    // State carried between blocks of a stream.
+    struct stream_state {
+        aho_corasick::state automaton = aho_corasick::START;
+        // A regex stream keeps its own DFA, so its state stays valid from block to block.
+        std::unique_ptr<lazy_dfa> dfa;
+        lazy_dfa::state regex_state = 0;
+        // Input searched for approximate matches so far.
+        std::size_t searched = 0;
+        // Whether the last block ended within a line.
+        bool within_line = false;
+    };
+
+    // Bytes from the end of one stream block that the next block must start with.
+    std::size_t overlap() const;
+
+    // Appends the matches in the next block of a stream, which starts with overlap() bytes of
+    // the previous one (fewer at the start of the input). offset is the position of data[0].
+    void find_next(const char *data, std::size_t size, std::size_t offset, stream_state &state,
+                   std::vector<match> &out, std::size_t max_matches = SIZE_MAX) const;
+
+    // Appends the match ending right at the end of a stream, `end` bytes long, if there is one.
+    // Only a regex can have such a match left after the last block.
+    void finish_stream(stream_state &state, std::size_t end, std::vector<match> &out,
+                       std::size_t max_matches = SIZE_MAX) const;
+
+private:
+    std::unique_ptr<searcher> _word;
+    std::unique_ptr<aho_corasick> _automaton;
+    std::unique_ptr<regex> _regex;
+    std::unique_ptr<approximate_searcher> _approximate;
+    // The word cut into max_errors + 1 pieces, one of which every approximate match contains
+    // unchanged; the automaton only runs around them. Empty if the pieces would be too short to
+    // be worth it.
+    std::vector<searcher> _pieces;
+    std::vector<std::size_t> _piece_offsets;
+    // Finds a string every regex match contains, when the matches stay within lines; lines
+    // without it are skipped.
+    std::unique_ptr<searcher> _prefilter;
+    std::size_t _longest;
+    // Added to word offsets: a regex that is a plain string is searched as a word but reports
+    // where matches end.
+    std::size_t _word_shift;
+    // DFAs not in use by any thread.
+    mutable std::mutex _dfa_lock;
+    mutable std::vector<std::unique_ptr<lazy_dfa>> _idle_dfas;
+
+    void find_regex(const char *data, std::size_t size, std::size_t begin, std::size_t end,
+                    std::vector<match> &out, std::size_t max_matches) const;
+
+    void find_next_regex(const char *data, std::size_t size, std::size_t offset, stream_state &state,
+                         std::vector<match> &out, std::size_t max_matches) const;
+
+    // Runs the DFA over data[0, size), which is at `offset` in the input, and appends the matches
+    // ending at or after `first`. Returns whether out has room for more.
+    bool scan_regex(lazy_dfa &dfa, lazy_dfa::state &s, const char *data, std::size_t size, std::size_t offset,
+                    std::size_t first, std::vector<match> &out, std::size_t max_matches) const;
+
+    void find_approximate(const char *data, std::size_t begin, std::size_t end, std::vector<match> &out,
+                          std::size_t max_matches) const;
+
+    // Runs the approximate automaton over data[from, to) from its start state and appends the
+    // matches ending at or after `first`. Returns whether out has room for more.
+    bool scan_approximate(const char *data, std::size_t from, std::size_t to, std::size_t first,
+                          std::vector<match> &out, std::size_t max_matches) const;
+
+    std::unique_ptr<lazy_dfa> take_dfa() const;
+
+    void return_dfa(std::unique_ptr<lazy_dfa> dfa) const;
+};
+
+#endif //SEARCH_MATCHER_H
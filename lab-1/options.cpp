@@ -0,0 +1,118 @@
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+#include "options.h"
+
+namespace {
+    void read_pattern_file(const std::string &path, std::vector<std::string> &patterns) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) throw std::invalid_argument("Can't open pattern file " + path);
+        std::string line;
+        while (std::getline(in, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            // Kept even when empty, so that pattern ids follow the line numbers; an empty pattern
+            // never matches.
+            patterns.push_back(line);
+        }
+    }
+
+    std::size_t parse_count(const char *value, const std::string &option) {
+        char *end = nullptr;
+        errno = 0;
+        unsigned long long n = strtoull(value, &end, 10);
+        if (errno != 0 || end == value || *end != '\0' || *value == '-') {
+            throw std::invalid_argument("Not a number after " + option + ": " + value);
+        }
+        return (std::size_t) n;
+    }
+
+    options parse_index_options(int argc, char *argv[]) {
+        options result;
+        result.build_index = true;
+        for (int i = 2; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--lcp") {
+                result.with_lcp = true;
+            } else if (arg == "--") {
+                result.paths.insert(result.paths.end(), argv + i + 1, argv + argc);
+                break;
+            } else {
+                result.paths.push_back(arg);
+            }
+        }
+        if (result.paths.empty()) throw std::invalid_argument("index needs the files to index");
+        for (const auto &path : result.paths) {
+            if (path == "-") throw std::invalid_argument("index needs files, not standard input");
+        }
+        return result;
+    }
+}
+
+options parse_options(int argc, char *argv[]) {
+    if (argc > 1 && strcmp(argv[1], "index") == 0) return parse_index_options(argc, argv);
+
+    options result;
+    std::vector<std::string> positional;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if ((arg == "-e" || arg == "-f" || arg == "-j" || arg == "--max" || arg == "--max-errors") && i + 1 == argc) {
+            throw std::invalid_argument("Missing value after " + arg);
+        }
+        if (arg == "-e") {
+            result.patterns.emplace_back(argv[++i]);
+            result.multi_pattern = true;
+        } else if (arg == "-f") {
+            read_pattern_file(argv[++i], result.patterns);
+            result.multi_pattern = true;
+        } else if (arg == "-j") {
+            result.threads = parse_count(argv[++i], arg);
+            if (result.threads == 0) throw std::invalid_argument("-j needs at least one thread");
+        } else if (arg == "--max") {
+            result.max_matches = parse_count(argv[++i], arg);
+        } else if (arg == "--max-errors") {
+            result.max_errors = parse_count(argv[++i], arg);
+            result.approximate = true;
+        } else if (arg == "--hamming") {
+            result.hamming = true;
+        } else if (arg == "-E") {
+            result.regex = true;
+        } else if (arg == "--count") {
+            result.count_only = true;
+        } else if (arg == "--binary") {
+            result.binary = true;
+        } else if (arg == "--") {
+            positional.insert(positional.end(), argv + i + 1, argv + argc);
+            break;
+        } else {
+            positional.push_back(arg);
+        }
+    }
+
+    if (result.threads == 0) result.threads = std::max(1u, std::thread::hardware_concurrency());
+    if (result.hamming && !result.approximate) throw std::invalid_argument("--hamming needs --max-errors");
+    if (result.approximate && (result.multi_pattern || result.regex)) {
+        throw std::invalid_argument("--max-errors takes a single word, not -e, -f or -E");
+    }
+
+    if (result.multi_pattern) {
+        if (result.regex) throw std::invalid_argument("-E takes a single pattern, not -e or -f");
+        result.paths = positional;
+        if (result.paths.empty()) result.paths.push_back("-");
+        return result;
+    }
+
+    if (positional.empty()) {
+        throw std::invalid_argument("Wrong number of arguments: " + std::to_string(argc) + " got, 3 expected");
+    }
+    // The word is the last argument, as it always was.
+    result.paths.assign(positional.begin(), positional.end() - 1);
+    if (result.paths.empty()) result.paths.push_back("-");
+    result.patterns.push_back(positional.back());
+    if (result.patterns[0].empty()) throw std::invalid_argument("The word to search for is empty");
+    return result;
+}
@@ -0,0 +1,54 @@
+#ifndef SEARCH_OPTIONS_H
+#define SEARCH_OPTIONS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Command line:
+//     search [flags] [path]... <word>
+//     search [flags] [-e pattern]... [-f pattern_file] [path]...
+//     search [flags] -E [path]... <regex>
+//     search index [--lcp] <file>...
+// Without a path, or with the path "-", standard input is searched. Several paths, or a
+// directory, are searched as a tree and matches are prefixed with the file's path.
+// Flags:
+//     -j threads  threads searching large files and trees
+//     --count     print only the number of matches (per file in a tree)
+//     --max N     stop after N matches (per file in a tree)
+//     --binary    print offsets as 8-byte little-endian numbers, each preceded by the pattern id
+//                 with several patterns and followed by the errors with --max-errors; only for
+//                 a single input
+//     --max-errors k  find the word with up to k inserted, deleted or substituted bytes
+//     --hamming   with --max-errors, only count substituted bytes
+// With -e or -f, every pattern is searched for in one pass and matches print as `pattern_id offset`,
+// pattern ids numbering the -e patterns first and then the lines of the pattern file, empty lines
+// included; an empty pattern never matches.
+// With -E the word is a regular expression (see regex.h), and every offset where a match of it
+// ends is printed. With --max-errors (see approximate.h), so is every offset where an approximate
+// match of the word ends, followed by the fewest errors of a match ending there.
+// `index` builds a suffix array of each file (see suffix_index.h), which later searches for a word
+// in that file alone use while it is up to date; --lcp adds the LCP array to it. A file named
+// `index` is searched as ./index.
+struct options {
+    std::vector<std::string> patterns;
+    bool multi_pattern = false;
+    bool regex = false;
+    std::vector<std::string> paths;
+    // Threads searching large files; defaults to one per core.
+    std::size_t threads = 0;
+    bool count_only = false;
+    std::size_t max_matches = SIZE_MAX;
+    bool binary = false;
+    bool approximate = false;
+    std::size_t max_errors = 0;
+    bool hamming = false;
+    bool build_index = false;
+    bool with_lcp = false;
+};
+
+// Throws std::invalid_argument with a message for the user on bad arguments.
+options parse_options(int argc, char *argv[]);
+
+#endif //SEARCH_OPTIONS_H
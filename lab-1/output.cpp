@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+#include <unistd.h>
+#include "output.h"
+
+namespace {
+    const char DIGIT_PAIRS[] =
+            "00010203040506070809"
+            "10111213141516171819"
+            "20212223242526272829"
+            "30313233343536373839"
+            "40414243444546474849"
+            "50515253545556575859"
+            "60616263646566676869"
+            "70717273747576777879"
+            "80818283848586878889"
+            "90919293949596979899";
+}
+
+char *format_decimal(std::uint64_t value, char *end) {
+    // Two digits per division.
+    while (value >= 100) {
+        std::size_t pair = (std::size_t) (value % 100) * 2;
+        value /= 100;
+        *--end = DIGIT_PAIRS[pair + 1];
+        *--end = DIGIT_PAIRS[pair];
+    }
+    if (value >= 10) {
+        std::size_t pair = (std::size_t) value * 2;
+        *--end = DIGIT_PAIRS[pair + 1];
+        *--end = DIGIT_PAIRS[pair];
+    } else {
+        *--end = (char) ('0' + value);
+    }
+    return end;
+}
+
+void append_decimal(std::string &out, std::uint64_t value) {
+    char digits[MAX_DECIMAL];
+    char *start = format_decimal(value, digits + MAX_DECIMAL);
+    out.append(start, digits + MAX_DECIMAL);
+}
+
+output_buffer::output_buffer(int fd) : _fd(fd), _buffer(CAPACITY), _used(0) {}
+
+output_buffer::~output_buffer() {
+    try {
+        flush();
+    } catch (const std::system_error &) {
+    }
+}
+
+void output_buffer::make_room(std::size_t bytes) {
+    if (_buffer.size() - _used < bytes) flush();
+}
+
+void output_buffer::write(const char *data, std::size_t size) {
+    if (size >= _buffer.size()) {
+        flush();
+        while (size > 0) {
+            ssize_t written = ::write(_fd, data, size);
+            if (written < 0 && errno == EINTR) continue;
+            if (written < 0) throw std::system_error(errno, std::generic_category(), "write");
+            data += written;
+            size -= (std::size_t) written;
+        }
+        return;
+    }
+    make_room(size);
+    memcpy(_buffer.data() + _used, data, size);
+    _used += size;
+}
+
+void output_buffer::put(char c) {
+    make_room(1);
+    _buffer[_used++] = c;
+}
+
+void output_buffer::put_decimal(std::uint64_t value) {
+    make_room(MAX_DECIMAL);
+    char digits[MAX_DECIMAL];
+    char *start = format_decimal(value, digits + MAX_DECIMAL);
+    std::size_t length = (std::size_t) (digits + MAX_DECIMAL - start);
+    memcpy(_buffer.data() + _used, start, length);
+    _used += length;
+}
+
+void output_buffer::put_binary(std::uint64_t value) {
+    make_room(8);
+    for (std::size_t i = 0; i < 8; i++) {
+        _buffer[_used++] = (char) (value >> (8 * i));
+    }
+}
+
+void output_buffer::flush() {
+    std::size_t done = 0;
+    while (done < _used) {
+        ssize_t written = ::write(_fd, _buffer.data() + done, _used - done);
+        if (written < 0 && errno == EINTR) continue;
+        if (written < 0) {
+            // Drop the output rather than retrying it from the destructor.
+            _used = 0;
+            throw std::system_error(errno, std::generic_category(), "write");
+        }
+        done += (std::size_t) written;
+    }
+    _used = 0;
+}
+
+match_writer::match_writer(const options &opts, bool multi_pattern, output_buffer &out)
+        : _opts(opts), _multi_pattern(multi_pattern), _out(out), _count(0) {}
+
+bool match_writer::add(const std::vector<match> &matches) {
+    std::size_t take = std::min(matches.size(), remaining());
+    _count += take;
+    if (!_opts.count_only) {
+        for (std::size_t k = 0; k < take; k++) {
+            const match &m = matches[k];
+            if (_opts.binary) {
+                if (_multi_pattern) _out.put_binary(m.pattern);
+                _out.put_binary(m.offset);
+                if (_opts.approximate) _out.put_binary(m.errors);
+                continue;
+            }
+            if (_multi_pattern) {
+                _out.put_decimal(m.pattern);
+                _out.put(' ');
+            }
+            _out.put_decimal(m.offset);
+            if (_opts.approximate) {
+                _out.put(' ');
+                _out.put_decimal(m.errors);
+            }
+            _out.put('\n');
+        }
+    }
+    return remaining() > 0;
+}
+
+bool match_writer::add_count(std::size_t count) {
+    _count += std::min(count, remaining());
+    return remaining() > 0;
+}
+
+std::size_t match_writer::remaining() const {
+    return _opts.max_matches - _count;
+}
+
+void match_writer::finish() {
+    if (!_opts.count_only) return;
+    _out.put_decimal(_count);
+    _out.put('\n');
+}
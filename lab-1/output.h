@@ -0,0 +1,80 @@
+#ifndef SEARCH_OUTPUT_H
+#define SEARCH_OUTPUT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "matcher.h"
+#include "options.h"
+
+// Longest decimal representation of a 64-bit number.
+const std::size_t MAX_DECIMAL = 20;
+
+// Writes the decimal digits of value so that they end right before `end`; returns where they start.
+char *format_decimal(std::uint64_t value, char *end);
+
+void append_decimal(std::string &out, std::uint64_t value);
+
+// Collects output in a large buffer and hands it to write() in big pieces instead of going
+// through stdio for every line.
+struct output_buffer {
+public:
+    static const std::size_t CAPACITY = std::size_t(1) << 18;
+
+    explicit output_buffer(int fd);
+
+    output_buffer(const output_buffer &) = delete;
+
+    output_buffer &operator=(const output_buffer &) = delete;
+
+    // Flushes what is left, ignoring errors; call flush() first to see them.
+    ~output_buffer();
+
+    void write(const char *data, std::size_t size);
+
+    void put(char c);
+
+    void put_decimal(std::uint64_t value);
+
+    // Little-endian, 8 bytes.
+    void put_binary(std::uint64_t value);
+
+    // Throws std::system_error if writing fails, e.g. with EPIPE when the reader went away.
+    void flush();
+
+private:
+    int _fd;
+    std::vector<char> _buffer;
+    std::size_t _used;
+
+    void make_room(std::size_t bytes);
+};
+
+// Prints matches in the format chosen on the command line: an offset per line (`pattern_id offset`
+// with several patterns, `offset errors` with --max-errors), binary records with --binary, or
+// only their number with --count. Stops accepting matches after --max of them.
+struct match_writer {
+public:
+    match_writer(const options &opts, bool multi_pattern, output_buffer &out);
+
+    // Returns false once --max matches have been taken; the rest of `matches` is dropped.
+    bool add(const std::vector<match> &matches);
+
+    // Takes `count` matches in --count mode, where their offsets aren't needed.
+    bool add_count(std::size_t count);
+
+    // How many more matches add() takes.
+    std::size_t remaining() const;
+
+    // Prints the count with --count.
+    void finish();
+
+private:
+    const options &_opts;
+    bool _multi_pattern;
+    output_buffer &_out;
+    std::size_t _count;
+};
+
+#endif //SEARCH_OUTPUT_H
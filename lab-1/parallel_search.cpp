@@ -0,0 +1,78 @@
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include "parallel_search.h"
+
+namespace {
+    struct chunk_result {
+        std::vector<match> matches;
+        std::exception_ptr error;
+        bool done = false;
+    };
+}
+
+void search_in_chunks(std::size_t size, std::size_t chunk_size, thread_pool &pool, const chunk_search &search,
+                      const std::function<bool(const std::vector<match> &)> &emit) {
+    const std::size_t chunks = (size + chunk_size - 1) / chunk_size;
+    const std::size_t window = 2 * pool.size();
+
+    std::mutex lock;
+    std::condition_variable finished;
+    // Reorder buffer: results of chunks [emitted, submitted), in order.
+    std::deque<std::shared_ptr<chunk_result>> pending;
+    std::size_t submitted = 0;
+
+    auto submit_next = [&] {
+        auto result = std::make_shared<chunk_result>();
+        pending.push_back(result);
+        std::size_t begin = submitted * chunk_size;
+        std::size_t end = std::min(begin + chunk_size, size);
+        submitted++;
+        pool.submit([&, result, begin, end] {
+            std::vector<match> found;
+            std::exception_ptr error;
+            try {
+                search(begin, end, found);
+            } catch (...) {
+                error = std::current_exception();
+            }
+            // Notifies under the lock: once the caller sees the last chunk done it returns,
+            // destroying `finished`.
+            std::lock_guard<std::mutex> guard(lock);
+            result->matches = std::move(found);
+            result->error = error;
+            result->done = true;
+            finished.notify_all();
+        });
+    };
+
+    std::exception_ptr error;
+    bool stopped = false;
+    while (submitted < chunks || !pending.empty()) {
+        while (submitted < chunks && pending.size() < window) {
+            submit_next();
+        }
+
+        std::shared_ptr<chunk_result> head = pending.front();
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            finished.wait(guard, [&] { return head->done; });
+        }
+        pending.pop_front();
+
+        if (head->error && !error) error = head->error;
+        if (!error && !stopped) {
+            try {
+                stopped = !emit(head->matches);
+            } catch (...) {
+                error = std::current_exception();
+            }
+        }
+        // Stop handing out work, but let the chunks in flight finish: they reference locals.
+        if (error || stopped) submitted = chunks;
+    }
+    if (error) std::rethrow_exception(error);
+}
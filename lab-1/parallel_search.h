@@ -0,0 +1,24 @@
+#ifndef SEARCH_PARALLEL_SEARCH_H
+#define SEARCH_PARALLEL_SEARCH_H
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+#include "matcher.h"
+#include "thread_pool.h"
+
+// Files of at least two chunks are searched in parallel.
+const std::size_t CHUNK_SIZE = std::size_t(16) << 20;
+
+// Collects the matches that belong to [begin, end) of the input. The function decides which
+// bytes around the range it has to look at; every match must belong to exactly one range.
+typedef std::function<void(std::size_t begin, std::size_t end, std::vector<match> &out)> chunk_search;
+
+// Splits [0, size) into chunks of `chunk_size` bytes and searches them on `pool`. The matches of
+// each chunk are passed to `emit` on the calling thread in chunk order, so output comes out as if
+// the input had been searched front to back. At most two chunks per thread are held at a time.
+// Once emit returns false no more chunks are started, and the results of those in flight are dropped.
+void search_in_chunks(std::size_t size, std::size_t chunk_size, thread_pool &pool, const chunk_search &search,
+                      const std::function<bool(const std::vector<match> &)> &emit);
+
+#endif //SEARCH_PARALLEL_SEARCH_H
@@ -0,0 +1,597 @@
+#include <algorithm>
+#include <stdexcept>
+#include "regex.h"
+
+namespace {
+    typedef std::bitset<256> byte_set;
+
+    const std::size_t UNBOUNDED = SIZE_MAX;
+    const std::size_t MAX_DEPTH = 256;
+
+    struct node {
+        enum kind_t {
+            EMPTY, BYTES, CONCAT, ALTERNATE, REPEAT, LINE_START, LINE_END, WORD_BOUNDARY, NOT_WORD_BOUNDARY
+        };
+
+        kind_t kind = EMPTY;
+        byte_set bytes;
+        std::vector<node> children;
+        // Repeat bounds; max may be UNBOUNDED.
+        std::size_t min = 0, max = 0;
+    };
+
+    node bytes_node(const byte_set &bytes) {
+        node n;
+        n.kind = node::BYTES;
+        n.bytes = bytes;
+        return n;
+    }
+
+    byte_set byte_range(unsigned char lo, unsigned char hi) {
+        byte_set set;
+        for (std::size_t b = lo; b <= hi; b++) {
+            set.set(b);
+        }
+        return set;
+    }
+
+    byte_set word_bytes() {
+        byte_set set;
+        for (std::size_t b = 0; b < 256; b++) {
+            set.set(b, regex::word_byte((unsigned char) b));
+        }
+        return set;
+    }
+
+    // Negated sets stop at the end of the line, like `.`.
+    byte_set negate(byte_set set) {
+        set.flip();
+        set.reset('\n');
+        return set;
+    }
+
+    struct parser {
+        const std::string &text;
+        std::size_t pos = 0;
+        std::size_t depth = 0;
+
+        explicit parser(const std::string &t) : text(t) {}
+
+        [[noreturn]] void fail(const std::string &what) const {
+            throw std::invalid_argument("Bad regex at offset " + std::to_string(pos) + ": " + what);
+        }
+
+        bool at_end() const { return pos == text.size(); }
+
+        char peek() const { return text[pos]; }
+
+        node parse() {
+            node n = alternation();
+            if (!at_end()) fail("unmatched )");
+            return n;
+        }
+
+        node alternation() {
+            node first = concatenation();
+            if (at_end() || peek() != '|') return first;
+            node n;
+            n.kind = node::ALTERNATE;
+            n.children.push_back(std::move(first));
+            while (!at_end() && peek() == '|') {
+                pos++;
+                n.children.push_back(concatenation());
+            }
+            return n;
+        }
+
+        node concatenation() {
+            node n;
+            n.kind = node::CONCAT;
+            while (!at_end() && peek() != '|' && peek() != ')') {
+                n.children.push_back(repeat());
+            }
+            if (n.children.empty()) return node();
+            if (n.children.size() == 1) return std::move(n.children[0]);
+            return n;
+        }
+
+        node repeat() {
+            node n = atom();
+            std::size_t min, max;
+            while (!at_end() && quantifier(min, max)) {
+                node r;
+                r.kind = node::REPEAT;
+                r.min = min;
+                r.max = max;
+                r.children.push_back(std::move(n));
+                n = std::move(r);
+                // Lazy repeats find the same match ends as greedy ones.
+                if (!at_end() && peek() == '?') pos++;
+            }
+            return n;
+        }
+
+        bool quantifier(std::size_t &min, std::size_t &max) {
+            switch (peek()) {
+                case '*':
+                    pos++;
+                    min = 0;
+                    max = UNBOUNDED;
+                    return true;
+                case '+':
+                    pos++;
+                    min = 1;
+                    max = UNBOUNDED;
+                    return true;
+                case '?':
+                    pos++;
+                    min = 0;
+                    max = 1;
+                    return true;
+                case '{':
+                    return bounds(min, max);
+                default:
+                    return false;
+            }
+        }
+
+        // {n}, {n,} or {n,m}; anything else leaves the brace to be read as a literal.
+        bool bounds(std::size_t &min, std::size_t &max) {
+            std::size_t p = pos + 1;
+            if (!number(p, min)) return false;
+            max = min;
+            if (p < text.size() && text[p] == ',') {
+                p++;
+                max = UNBOUNDED;
+                if (p < text.size() && text[p] != '}' && !number(p, max)) return false;
+            }
+            if (p == text.size() || text[p] != '}') return false;
+            pos = p + 1;
+            if (min > regex::MAX_REPEAT || (max != UNBOUNDED && max > regex::MAX_REPEAT)) {
+                fail("repeat count too large");
+            }
+            if (max < min) fail("repeat bounds out of order");
+            return true;
+        }
+
+        bool number(std::size_t &p, std::size_t &value) const {
+            std::size_t begin = p;
+            value = 0;
+            while (p < text.size() && text[p] >= '0' && text[p] <= '9') {
+                value = std::min(value * 10 + (std::size_t) (text[p] - '0'), regex::MAX_REPEAT + 1);
+                p++;
+            }
+            return p > begin;
+        }
+
+        node atom() {
+            char c = peek();
+            switch (c) {
+                case '(': {
+                    pos++;
+                    if (text.compare(pos, 2, "?:") == 0) {
+                        pos += 2;
+                    } else if (!at_end() && peek() == '?') {
+                        fail("unsupported group");
+                    }
+                    if (++depth > MAX_DEPTH) fail("groups nested too deeply");
+                    node n = alternation();
+                    depth--;
+                    if (at_end()) fail("missing )");
+                    pos++;
+                    return n;
+                }
+                case '[':
+                    pos++;
+                    return bytes_node(byte_class());
+                case '.':
+                    pos++;
+                    return bytes_node(negate(byte_set()));
+                case '^':
+                case '$': {
+                    pos++;
+                    node n;
+                    n.kind = c == '^' ? node::LINE_START : node::LINE_END;
+                    return n;
+                }
+                case '*':
+                case '+':
+                case '?':
+                    fail("nothing to repeat");
+                case '\\': {
+                    pos++;
+                    if (!at_end() && (peek() == 'b' || peek() == 'B')) {
+                        node n;
+                        n.kind = text[pos++] == 'b' ? node::WORD_BOUNDARY : node::NOT_WORD_BOUNDARY;
+                        return n;
+                    }
+                    byte_set set;
+                    escape(set);
+                    return bytes_node(set);
+                }
+                default:
+                    pos++;
+                    return bytes_node(byte_set().set((unsigned char) c));
+            }
+        }
+
+        // Reads the escape after a backslash into set; returns false if it stands for a class
+        // rather than a single byte.
+        bool escape(byte_set &set) {
+            if (at_end()) fail("trailing backslash");
+            char c = text[pos++];
+            switch (c) {
+                case 'd':
+                case 'D':
+                    set = byte_range('0', '9');
+                    break;
+                case 'w':
+                case 'W':
+                    set = word_bytes();
+                    break;
+                case 's':
+                case 'S':
+                    set = byte_set().set(' ').set('\t').set('\r').set('\f').set('\v');
+                    break;
+                case 'n':
+                    set.set('\n');
+                    return true;
+                case 't':
+                    set.set('\t');
+                    return true;
+                case 'r':
+                    set.set('\r');
+                    return true;
+                case 'f':
+                    set.set('\f');
+                    return true;
+                case 'v':
+                    set.set('\v');
+                    return true;
+                case 'x': {
+                    int value = 0;
+                    for (int k = 0; k < 2; k++) {
+                        int digit = at_end() ? -1 : hex_digit(peek());
+                        if (digit < 0) fail("\\x needs two hex digits");
+                        value = value * 16 + digit;
+                        pos++;
+                    }
+                    set.set((std::size_t) value);
+                    return true;
+                }
+                default:
+                    if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')) {
+                        pos--;
+                        fail(std::string("unknown escape \\") + c);
+                    }
+                    set.set((unsigned char) c);
+                    return true;
+            }
+            if (c >= 'A' && c <= 'Z') set = negate(set);
+            return false;
+        }
+
+        static int hex_digit(char c) {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            return -1;
+        }
+
+        // One member of a bracketed class: a byte, or a class escape such as \d.
+        bool class_member(byte_set &set) {
+            if (at_end()) fail("missing ]");
+            if (peek() == '\\') {
+                pos++;
+                return escape(set);
+            }
+            set.set((unsigned char) text[pos++]);
+            return true;
+        }
+
+        // After the opening bracket, up to and including the closing one.
+        byte_set byte_class() {
+            bool negated = !at_end() && peek() == '^';
+            if (negated) pos++;
+            byte_set result;
+            bool first = true;
+            while (true) {
+                if (at_end()) fail("missing ]");
+                if (peek() == ']' && !first) {
+                    pos++;
+                    break;
+                }
+                first = false;
+                byte_set member;
+                bool single = class_member(member);
+                if (single && pos + 1 < text.size() && peek() == '-' && text[pos + 1] != ']') {
+                    pos++;
+                    byte_set upper;
+                    if (!class_member(upper)) fail("class escape in a range");
+                    std::size_t lo = 0, hi = 0;
+                    while (!member.test(lo)) lo++;
+                    while (!upper.test(hi)) hi++;
+                    if (hi < lo) fail("range out of order");
+                    member = byte_range((unsigned char) lo, (unsigned char) hi);
+                }
+                result |= member;
+            }
+            return negated ? negate(result) : result;
+        }
+    };
+
+    // Appends instructions for n, continuing at `next`, and returns where they start. Building
+    // back to front means every target is known when an instruction is emitted, except a loop's
+    // back edge, which is patched.
+    struct compiler {
+        std::vector<regex::instruction> &program;
+        std::vector<byte_set> &sets;
+
+        std::uint32_t emit(regex::instruction::kind_t kind, std::uint32_t next, std::uint32_t alt = 0,
+                           std::uint32_t set = 0) {
+            if (program.size() >= regex::MAX_PROGRAM) throw std::invalid_argument("Regex is too large");
+            program.push_back(regex::instruction{kind, next, alt, set});
+            return (std::uint32_t) (program.size() - 1);
+        }
+
+        std::uint32_t compile(const node &n, std::uint32_t next) {
+            switch (n.kind) {
+                case node::EMPTY:
+                    return next;
+                case node::BYTES:
+                    sets.push_back(n.bytes);
+                    return emit(regex::instruction::BYTES, next, 0, (std::uint32_t) (sets.size() - 1));
+                case node::LINE_START:
+                    return emit(regex::instruction::LINE_START, next);
+                case node::LINE_END:
+                    return emit(regex::instruction::LINE_END, next);
+                case node::WORD_BOUNDARY:
+                    return emit(regex::instruction::WORD_BOUNDARY, next);
+                case node::NOT_WORD_BOUNDARY:
+                    return emit(regex::instruction::NOT_WORD_BOUNDARY, next);
+                case node::CONCAT:
+                    for (auto it = n.children.rbegin(); it != n.children.rend(); ++it) {
+                        next = compile(*it, next);
+                    }
+                    return next;
+                case node::ALTERNATE: {
+                    std::uint32_t entry = compile(n.children.back(), next);
+                    for (std::size_t k = n.children.size() - 1; k-- > 0;) {
+                        entry = emit(regex::instruction::SPLIT, compile(n.children[k], next), entry);
+                    }
+                    return entry;
+                }
+                case node::REPEAT:
+                    return compile_repeat(n.children[0], n.min, n.max, next);
+            }
+            return next;
+        }
+
+        std::uint32_t compile_repeat(const node &child, std::size_t min, std::size_t max, std::uint32_t next) {
+            std::uint32_t entry = next;
+            std::size_t copies = min;
+            if (max == UNBOUNDED) {
+                // x* is a split in front of x looping back to it; x+ enters at x instead.
+                std::uint32_t loop = emit(regex::instruction::SPLIT, 0, next);
+                std::uint32_t body = compile(child, loop);
+                program[loop].next = body;
+                entry = loop;
+                if (copies > 0) {
+                    entry = body;
+                    copies--;
+                }
+            } else {
+                // x{0,k}: each optional copy may skip to the end.
+                for (std::size_t k = min; k < max; k++) {
+                    entry = emit(regex::instruction::SPLIT, compile(child, entry), next);
+                }
+            }
+            for (std::size_t k = 0; k < copies; k++) {
+                entry = compile(child, entry);
+            }
+            return entry;
+        }
+    };
+
+    // What the literal prefilter can use of a node: the string it always matches, if there is
+    // only one, or else the longest string all of its matches contain.
+    struct literal {
+        bool exact;
+        std::string text;
+    };
+
+    literal required_literal(const node &n) {
+        switch (n.kind) {
+            case node::EMPTY:
+                return literal{true, ""};
+            case node::LINE_START:
+            case node::LINE_END:
+            case node::WORD_BOUNDARY:
+            case node::NOT_WORD_BOUNDARY:
+                // Zero width, but not plain text either.
+                return literal{false, ""};
+            case node::BYTES:
+                if (n.bytes.count() != 1) return literal{false, ""};
+                for (std::size_t b = 0; b < 256; b++) {
+                    if (n.bytes.test(b)) return literal{true, std::string(1, (char) b)};
+                }
+                break;
+            case node::CONCAT: {
+                // Adjacent exact parts join into one string.
+                std::string run, best;
+                bool exact = true;
+                for (const auto &child : n.children) {
+                    literal part = required_literal(child);
+                    if (part.exact) {
+                        run += part.text;
+                        continue;
+                    }
+                    exact = false;
+                    if (run.size() > best.size()) best = run;
+                    if (part.text.size() > best.size()) best = part.text;
+                    run.clear();
+                }
+                if (run.size() > best.size()) best = run;
+                return literal{exact, exact ? run : best};
+            }
+            case node::ALTERNATE: {
+                literal first = required_literal(n.children[0]);
+                for (const auto &child : n.children) {
+                    literal other = required_literal(child);
+                    if (!first.exact || !other.exact || other.text != first.text) return literal{false, ""};
+                }
+                return first;
+            }
+            case node::REPEAT: {
+                literal part = required_literal(n.children[0]);
+                if (n.min == 0) return literal{n.max == 0, ""};
+                if (!part.exact) return literal{false, part.text};
+                std::string text;
+                for (std::size_t k = 0; k < n.min; k++) {
+                    text += part.text;
+                }
+                return literal{n.min == n.max, text};
+            }
+        }
+        return literal{false, ""};
+    }
+
+    std::size_t saturating_add(std::size_t a, std::size_t b) {
+        return a > UNBOUNDED - b ? UNBOUNDED : a + b;
+    }
+
+    std::size_t saturating_multiply(std::size_t a, std::size_t b) {
+        return b != 0 && a > UNBOUNDED / b ? UNBOUNDED : a * b;
+    }
+
+    // Shortest and longest match lengths.
+    void length_bounds(const node &n, std::size_t &min, std::size_t &max) {
+        min = max = 0;
+        switch (n.kind) {
+            case node::EMPTY:
+            case node::LINE_START:
+            case node::LINE_END:
+            case node::WORD_BOUNDARY:
+            case node::NOT_WORD_BOUNDARY:
+                return;
+            case node::BYTES:
+                min = max = 1;
+                return;
+            case node::CONCAT:
+                for (const auto &child : n.children) {
+                    std::size_t lo, hi;
+                    length_bounds(child, lo, hi);
+                    min = saturating_add(min, lo);
+                    max = saturating_add(max, hi);
+                }
+                return;
+            case node::ALTERNATE:
+                min = UNBOUNDED;
+                for (const auto &child : n.children) {
+                    std::size_t lo, hi;
+                    length_bounds(child, lo, hi);
+                    min = std::min(min, lo);
+                    max = std::max(max, hi);
+                }
+                return;
+            case node::REPEAT: {
+                std::size_t lo, hi;
+                length_bounds(n.children[0], lo, hi);
+                min = saturating_multiply(lo, n.min);
+                max = n.max == UNBOUNDED ? (hi == 0 ? 0 : UNBOUNDED) : saturating_multiply(hi, n.max);
+                return;
+            }
+        }
+    }
+}
+
+regex::regex(const std::string &pattern) {
+    node root = parser(pattern).parse();
+
+    std::size_t min_length;
+    length_bounds(root, min_length, _max_length);
+    if (min_length == 0) throw std::invalid_argument("Regex matches the empty string");
+
+    compiler c{_program, _sets};
+    std::uint32_t match = c.emit(instruction::MATCH, 0);
+    _start = c.compile(root, match);
+
+    literal lit = required_literal(root);
+    _required = lit.text;
+    _plain_string = lit.exact;
+
+    _matches_newline = false;
+    for (const auto &set : _sets) {
+        _matches_newline = _matches_newline || set.test('\n');
+    }
+
+    // Split the bytes until every set is a union of classes, starting from a newline class.
+    std::vector<byte_set> splits = _sets;
+    for (const auto &ins : _program) {
+        if (ins.kind == instruction::WORD_BOUNDARY || ins.kind == instruction::NOT_WORD_BOUNDARY) {
+            splits.push_back(word_bytes());
+            break;
+        }
+    }
+    std::fill(std::begin(_class), std::end(_class), 0);
+    _class[(unsigned char) '\n'] = 1;
+    _classes = 2;
+    for (const auto &set : splits) {
+        std::vector<int> inside(_classes, -1), outside(_classes, -1);
+        std::size_t classes = 0;
+        for (std::size_t b = 0; b < 256; b++) {
+            int &target = set.test(b) ? inside[_class[b]] : outside[_class[b]];
+            if (target < 0) target = (int) classes++;
+            _class[b] = (std::uint8_t) target;
+        }
+        _classes = classes;
+    }
+    _class_byte.resize(_classes);
+    for (std::size_t b = 256; b-- > 0;) {
+        _class_byte[_class[b]] = (unsigned char) b;
+    }
+}
+
+bool regex::word_byte(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+const std::vector<regex::instruction> &regex::program() const {
+    return _program;
+}
+
+std::uint32_t regex::start() const {
+    return _start;
+}
+
+const std::vector<std::bitset<256>> &regex::sets() const {
+    return _sets;
+}
+
+std::size_t regex::classes() const {
+    return _classes;
+}
+
+const std::uint8_t *regex::byte_classes() const {
+    return _class;
+}
+
+unsigned char regex::class_byte(std::size_t cls) const {
+    return _class_byte[cls];
+}
+
+const std::string &regex::required() const {
+    return _required;
+}
+
+bool regex::plain_string() const {
+    return _plain_string;
+}
+
+std::size_t regex::max_length() const {
+    return _max_length;
+}
+
+bool regex::matches_newline() const {
+    return _matches_newline;
+}
@@ -0,0 +1,88 @@
+#ifndef SEARCH_REGEX_H
+#define SEARCH_REGEX_H
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A regular expression compiled to a Thompson NFA, which lazy_dfa runs. Supported syntax:
+// literal bytes, `.`, classes (`[a-z_]`, `[^0-9]`), the escapes \d \w \s \D \W \S \n \t \r \f \v
+// \xHH, groups `(...)` and `(?:...)`, `|`, and the repeats `*`, `+`, `?`, `{n}`, `{n,}`, `{n,m}`.
+// `^` and `$` match at the start and end of a line, \b and \B at word boundaries and elsewhere.
+// Matches stay within a line: `.`, negated classes and the upper case escapes don't match a
+// newline, only a spelled out one (\n) does.
+struct regex {
+public:
+    // Longest count allowed in {n,m}.
+    static const std::size_t MAX_REPEAT = 1000;
+
+    // Most instructions a pattern may compile to.
+    static const std::size_t MAX_PROGRAM = std::size_t(1) << 16;
+
+    // Throws std::invalid_argument with a message for the user on bad syntax, on a pattern that
+    // is too large, and on one that matches the empty string (it would match everywhere).
+    explicit regex(const std::string &pattern);
+
+    // Letters, digits and underscores, as in \w and \b.
+    static bool word_byte(unsigned char c);
+
+    struct instruction {
+        enum kind_t : std::uint8_t {
+            BYTES,      // consumes a byte in sets()[set]
+            SPLIT,      // continues at both next and alt
+            LINE_START,
+            LINE_END,
+            WORD_BOUNDARY,
+            NOT_WORD_BOUNDARY,
+            MATCH
+        };
+
+        kind_t kind;
+        std::uint32_t next;
+        std::uint32_t alt;
+        std::uint32_t set;
+    };
+
+    const std::vector<instruction> &program() const;
+
+    std::uint32_t start() const;
+
+    const std::vector<std::bitset<256>> &sets() const;
+
+    // Bytes that no instruction tells apart share a class. A newline always has one of its own,
+    // and with \b or \B word bytes don't share one with others.
+    std::size_t classes() const;
+
+    const std::uint8_t *byte_classes() const;
+
+    // Some byte of each class.
+    unsigned char class_byte(std::size_t cls) const;
+
+    // A string every match contains, or an empty one if none was found.
+    const std::string &required() const;
+
+    // Whether the pattern only matches required() itself.
+    bool plain_string() const;
+
+    // Length of the longest match, or SIZE_MAX if there is no limit.
+    std::size_t max_length() const;
+
+    // Whether a match may contain a newline.
+    bool matches_newline() const;
+
+private:
+    std::vector<instruction> _program;
+    std::uint32_t _start;
+    std::vector<std::bitset<256>> _sets;
+    std::uint8_t _class[256];
+    std::size_t _classes;
+    std::vector<unsigned char> _class_byte;
+    std::string _required;
+    bool _plain_string;
+    std::size_t _max_length;
+    bool _matches_newline;
+};
+
+#endif //SEARCH_REGEX_H
@@ -0,0 +1,147 @@
+#include <cassert>
+#include <cstring>
+#include <utility>
+#include "search.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SEARCH_X86 1
+#endif
+
+namespace {
+    bool has_avx2() {
+#ifdef SEARCH_X86
+        static const bool supported = __builtin_cpu_supports("avx2");
+        return supported;
+#else
+        return false;
+#endif
+    }
+
+    bool has_sse2() {
+#ifdef SEARCH_X86
+        static const bool supported = __builtin_cpu_supports("sse2");
+        return supported;
+#else
+        return false;
+#endif
+    }
+
+    // Positions are candidates once the first and last bytes match; this compares the bytes in between.
+    inline bool middle_matches(const char *at, const std::string &pattern) {
+        return pattern.size() <= 2 || memcmp(at + 1, pattern.data() + 1, pattern.size() - 2) == 0;
+    }
+}
+
+searcher::searcher(std::string pattern) : _pattern(std::move(pattern)) {
+    assert(!_pattern.empty());
+    std::size_t m = _pattern.size();
+
+    if (m == 1) {
+        _find = find_byte;
+    } else if (m >= LONG_PATTERN) {
+        _find = find_horspool;
+    } else if (has_avx2()) {
+        _find = find_avx2;
+    } else if (has_sse2()) {
+        _find = find_sse2;
+    } else {
+        _find = find_scalar;
+    }
+
+    for (auto &shift : _shift) {
+        shift = (std::uint32_t) m;
+    }
+    for (std::size_t i = 0; i + 1 < m; i++) {
+        _shift[(unsigned char) _pattern[i]] = (std::uint32_t) (m - 1 - i);
+    }
+}
+
+const std::string &searcher::pattern() const {
+    return _pattern;
+}
+
+std::size_t searcher::find(const char *data, std::size_t size, std::size_t from) const {
+    if (from >= size || size - from < _pattern.size()) return size;
+    return _find(*this, data, size, from);
+}
+
+std::size_t searcher::find_byte(const searcher &s, const char *data, std::size_t size, std::size_t from) {
+    auto *found = (const char *) memchr(data + from, s._pattern[0], size - from);
+    return found ? (std::size_t) (found - data) : size;
+}
+
+std::size_t searcher::find_scalar(const searcher &s, const char *data, std::size_t size, std::size_t from) {
+    const std::string &p = s._pattern;
+    std::size_t last = size - p.size();
+    while (from <= last) {
+        auto *found = (const char *) memchr(data + from, p[0], last - from + 1);
+        if (!found) break;
+        from = (std::size_t) (found - data);
+        if (found[p.size() - 1] == p.back() && middle_matches(found, p)) return from;
+        from++;
+    }
+    return size;
+}
+
+#ifdef SEARCH_X86
+__attribute__((target("sse2")))
+std::size_t searcher::find_sse2(const searcher &s, const char *data, std::size_t size, std::size_t from) {
+    const std::string &p = s._pattern;
+    const std::size_t m = p.size();
+    const __m128i first = _mm_set1_epi8(p[0]);
+    const __m128i last = _mm_set1_epi8(p[m - 1]);
+
+    for (; from + m - 1 + 16 <= size; from += 16) {
+        __m128i head = _mm_loadu_si128((const __m128i *) (data + from));
+        __m128i tail = _mm_loadu_si128((const __m128i *) (data + from + m - 1));
+        auto mask = (unsigned) _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(head, first), _mm_cmpeq_epi8(tail, last)));
+        while (mask) {
+            std::size_t at = from + __builtin_ctz(mask);
+            if (middle_matches(data + at, p)) return at;
+            mask &= mask - 1;
+        }
+    }
+    return find_scalar(s, data, size, from);
+}
+
+__attribute__((target("avx2")))
+std::size_t searcher::find_avx2(const searcher &s, const char *data, std::size_t size, std::size_t from) {
+    const std::string &p = s._pattern;
+    const std::size_t m = p.size();
+    const __m256i first = _mm256_set1_epi8(p[0]);
+    const __m256i last = _mm256_set1_epi8(p[m - 1]);
+
+    for (; from + m - 1 + 32 <= size; from += 32) {
+        __m256i head = _mm256_loadu_si256((const __m256i *) (data + from));
+        __m256i tail = _mm256_loadu_si256((const __m256i *) (data + from + m - 1));
+        auto mask = (unsigned) _mm256_movemask_epi8(
+                _mm256_and_si256(_mm256_cmpeq_epi8(head, first), _mm256_cmpeq_epi8(tail, last)));
+        while (mask) {
+            std::size_t at = from + __builtin_ctz(mask);
+            if (middle_matches(data + at, p)) return at;
+            mask &= mask - 1;
+        }
+    }
+    return find_scalar(s, data, size, from);
+}
+#else
+std::size_t searcher::find_sse2(const searcher &s, const char *data, std::size_t size, std::size_t from) {
+    return find_scalar(s, data, size, from);
+}
+
+std::size_t searcher::find_avx2(const searcher &s, const char *data, std::size_t size, std::size_t from) {
+    return find_scalar(s, data, size, from);
+}
+#endif
+
+std::size_t searcher::find_horspool(const searcher &s, const char *data, std::size_t size, std::size_t from) {
+    const std::string &p = s._pattern;
+    const std::size_t m = p.size();
+    const char last = p[m - 1];
+
+    for (std::size_t end = from + m - 1; end < size; end += s._shift[(unsigned char) data[end]]) {
+        if (data[end] == last && memcmp(data + end - m + 1, p.data(), m - 1) == 0) return end - m + 1;
+    }
+    return size;
+}
@@ -0,0 +1,44 @@
+#ifndef SEARCH_SEARCH_H
+#define SEARCH_SEARCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Finds occurrences of one pattern in a buffer, overlapping ones included. Short patterns are
+// found with a vectorized filter on the first and last byte (AVX2 or SSE2, picked at runtime)
+// that only compares the middle of the pattern at candidate positions. Long patterns use
+// Boyer-Moore-Horspool, which skips up to the pattern length at a time.
+struct searcher {
+public:
+    // Patterns at least this long use Horspool.
+    static const std::size_t LONG_PATTERN = 64;
+
+    // The pattern must not be empty.
+    explicit searcher(std::string pattern);
+
+    const std::string &pattern() const;
+
+    // Offset of the first occurrence starting at or after `from`, or `size` if there is none.
+    std::size_t find(const char *data, std::size_t size, std::size_t from = 0) const;
+
+private:
+    typedef std::size_t (*find_function)(const searcher &s, const char *data, std::size_t size, std::size_t from);
+
+    std::string _pattern;
+    find_function _find;
+    // Horspool shifts, indexed by the byte aligned with the end of the pattern.
+    std::uint32_t _shift[256];
+
+    static std::size_t find_byte(const searcher &s, const char *data, std::size_t size, std::size_t from);
+
+    static std::size_t find_scalar(const searcher &s, const char *data, std::size_t size, std::size_t from);
+
+    static std::size_t find_sse2(const searcher &s, const char *data, std::size_t size, std::size_t from);
+
+    static std::size_t find_avx2(const searcher &s, const char *data, std::size_t size, std::size_t from);
+
+    static std::size_t find_horspool(const searcher &s, const char *data, std::size_t size, std::size_t from);
+};
+
+#endif //SEARCH_SEARCH_H
@@ -0,0 +1,151 @@
+#include <algorithm>
+#include <vector>
+#include "suffix_array.h"
+
+namespace {
+    // Points bucket[c] at the first slot of the suffixes starting with c, or one past the last.
+    template<typename Index, typename Char>
+    void bucket_edges(const Char *s, Index n, std::vector<Index> &bucket, bool ends) {
+        std::fill(bucket.begin(), bucket.end(), 0);
+        for (Index i = 0; i < n; i++) bucket[s[i]]++;
+        Index sum = 0;
+        for (auto &b : bucket) {
+            sum += b;
+            b = ends ? sum : sum - b;
+        }
+    }
+
+    // Sorts the L-type suffixes from the sorted LMS ones at the ends of their buckets, then the
+    // S-type ones from those. The input ends with a virtual sentinel smaller than every character.
+    template<typename Index, typename Char>
+    void induce(const Char *s, Index n, const std::vector<bool> &stype, std::vector<Index> &bucket, Index *sa) {
+        const Index EMPTY = ~Index(0);
+        bucket_edges(s, n, bucket, false);
+        // The sentinel comes first, and the last suffix is right before it.
+        sa[bucket[s[n - 1]]++] = n - 1;
+        for (Index k = 0; k < n; k++) {
+            Index j = sa[k];
+            if (j != EMPTY && j > 0 && !stype[j - 1]) sa[bucket[s[j - 1]]++] = j - 1;
+        }
+        bucket_edges(s, n, bucket, true);
+        for (Index k = n; k-- > 0;) {
+            Index j = sa[k];
+            if (j != EMPTY && j > 0 && stype[j - 1]) sa[--bucket[s[j - 1]]] = j - 1;
+        }
+    }
+
+    template<typename Index, typename Char>
+    void sa_is(const Char *s, Index n, std::size_t alphabet, Index *sa) {
+        const Index EMPTY = ~Index(0);
+        if (n == 0) return;
+        if (n == 1) {
+            sa[0] = 0;
+            return;
+        }
+
+        // A suffix is S-type if it is smaller than the next one, L-type otherwise; the last one
+        // is L-type, being larger than the sentinel.
+        std::vector<bool> stype(n);
+        for (Index i = n - 1; i-- > 0;) {
+            stype[i] = s[i] < s[i + 1] || (s[i] == s[i + 1] && stype[i + 1]);
+        }
+        auto lms = [&stype](Index i) { return i > 0 && stype[i] && !stype[i - 1]; };
+        std::vector<Index> bucket(alphabet);
+
+        // Inducing from the LMS suffixes in any order sorts them by their LMS substrings, which
+        // run up to the next LMS position.
+        std::fill(sa, sa + n, EMPTY);
+        bucket_edges(s, n, bucket, true);
+        for (Index i = 1; i < n; i++) {
+            if (lms(i)) sa[--bucket[s[i]]] = i;
+        }
+        induce(s, n, stype, bucket, sa);
+
+        Index lms_count = 0;
+        for (Index k = 0; k < n; k++) {
+            if (lms(sa[k])) sa[lms_count++] = sa[k];
+        }
+
+        // Name the LMS substrings by rank, equal ones alike. LMS positions are at least two apart,
+        // so the names fit in the free half of sa, at half their positions.
+        std::fill(sa + lms_count, sa + n, EMPTY);
+        Index names = 0;
+        Index previous = EMPTY;
+        for (Index k = 0; k < lms_count; k++) {
+            Index pos = sa[k];
+            bool same = previous != EMPTY;
+            for (Index d = 0; same; d++) {
+                // The substring ending at the sentinel is unlike any other.
+                if (pos + d == n || previous + d == n || s[pos + d] != s[previous + d] ||
+                    stype[pos + d] != stype[previous + d]) {
+                    same = false;
+                } else if (d > 0 && lms(pos + d)) {
+                    break;
+                }
+            }
+            if (!same) names++;
+            previous = pos;
+            sa[lms_count + pos / 2] = names - 1;
+        }
+        Index *reduced = sa + n - lms_count;
+        for (Index k = n, j = n; k-- > lms_count;) {
+            if (sa[k] != EMPTY) sa[--j] = sa[k];
+        }
+
+        // The order of the LMS suffixes is the order of the suffixes of the string of names.
+        if (names < lms_count) {
+            sa_is<Index, Index>(reduced, lms_count, names, sa);
+        } else {
+            for (Index k = 0; k < lms_count; k++) sa[reduced[k]] = k;
+        }
+
+        for (Index i = 1, j = 0; i < n; i++) {
+            if (lms(i)) reduced[j++] = i;
+        }
+        for (Index k = 0; k < lms_count; k++) sa[k] = reduced[sa[k]];
+        std::fill(sa + lms_count, sa + n, EMPTY);
+        bucket_edges(s, n, bucket, true);
+        for (Index k = lms_count; k-- > 0;) {
+            Index j = sa[k];
+            sa[k] = EMPTY;
+            sa[--bucket[s[j]]] = j;
+        }
+        induce(s, n, stype, bucket, sa);
+    }
+}
+
+template<typename Index>
+void build_suffix_array(const unsigned char *text, Index n, Index *sa) {
+    sa_is<Index, unsigned char>(text, n, 256, sa);
+}
+
+template<typename Index>
+void build_lcp_array(const unsigned char *text, Index n, const Index *sa, Index *lcp) {
+    if (n == 0) return;
+    const Index NONE = ~Index(0);
+    // The suffix before each one in sa, then in its place the common prefix with it; that drops
+    // by at most one from a position to the next, which makes the whole pass linear.
+    std::vector<Index> prefix(n);
+    prefix[sa[0]] = NONE;
+    for (Index k = 1; k < n; k++) prefix[sa[k]] = sa[k - 1];
+    Index h = 0;
+    for (Index i = 0; i < n; i++) {
+        Index previous = prefix[i];
+        if (previous == NONE) {
+            prefix[i] = 0;
+            h = 0;
+            continue;
+        }
+        while (i + h < n && previous + h < n && text[i + h] == text[previous + h]) h++;
+        prefix[i] = h;
+        if (h > 0) h--;
+    }
+    for (Index k = 0; k < n; k++) lcp[k] = prefix[sa[k]];
+}
+
+template void build_suffix_array<std::uint32_t>(const unsigned char *, std::uint32_t, std::uint32_t *);
+template void build_suffix_array<std::uint64_t>(const unsigned char *, std::uint64_t, std::uint64_t *);
+template void build_lcp_array<std::uint32_t>(const unsigned char *, std::uint32_t, const std::uint32_t *,
+                                             std::uint32_t *);
+template void build_lcp_array<std::uint64_t>(const unsigned char *, std::uint64_t, const std::uint64_t *,
+                                             std::uint64_t *);
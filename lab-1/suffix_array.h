@@ -0,0 +1,19 @@
+#ifndef SEARCH_SUFFIX_ARRAY_H
+#define SEARCH_SUFFIX_ARRAY_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Sorts the suffixes of text[0, n) in linear time with SA-IS (Nong, Zhang and Chan): sa[k] is
+// where the k-th smallest suffix starts. Index is std::uint32_t or std::uint64_t, and n must be
+// smaller than its largest value. Besides sa, it takes n / 8 bytes and an Index per distinct
+// LMS substring.
+template<typename Index>
+void build_suffix_array(const unsigned char *text, Index n, Index *sa);
+
+// Fills lcp[k] with the length of the longest common prefix of the suffixes at sa[k - 1] and
+// sa[k] (Kasai et al.), and lcp[0] with 0. Takes n more Indexes while it runs.
+template<typename Index>
+void build_lcp_array(const unsigned char *text, Index n, const Index *sa, Index *lcp);
+
+#endif //SEARCH_SUFFIX_ARRAY_H
@@ -0,0 +1,237 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "suffix_array.h"
+#include "suffix_index.h"
+
+namespace {
+    const char MAGIC[8] = {'S', 'E', 'A', 'R', 'C', 'H', 'S', 'A'};
+    const std::uint32_t VERSION = 2;
+
+    // Followed by the suffix array and then the LCP array, `width` bytes per entry. Everything is
+    // in the byte order of the machine that built it; on another one the version doesn't match.
+    struct header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t width;
+        std::uint64_t file_size;
+        std::uint64_t device;
+        std::uint64_t inode;
+        std::int64_t modified_seconds;
+        std::int64_t modified_nanoseconds;
+        // The modification time can be set back, but not the change time, which any write
+        // updates.
+        std::int64_t changed_seconds;
+        std::int64_t changed_nanoseconds;
+        std::uint64_t with_lcp;
+    };
+
+    static_assert(sizeof(header) == 80, "the arrays must stay aligned");
+
+    [[noreturn]] void throw_errno(int error, const std::string &what) {
+        throw std::system_error(error, std::generic_category(), what);
+    }
+
+    header describe(const struct stat &st) {
+        header h{};
+        memcpy(h.magic, MAGIC, sizeof(MAGIC));
+        h.version = VERSION;
+        h.width = st.st_size < UINT32_MAX ? 4 : 8;
+        h.file_size = (std::uint64_t) st.st_size;
+        h.device = (std::uint64_t) st.st_dev;
+        h.inode = (std::uint64_t) st.st_ino;
+        h.modified_seconds = st.st_mtim.tv_sec;
+        h.modified_nanoseconds = st.st_mtim.tv_nsec;
+        h.changed_seconds = st.st_ctim.tv_sec;
+        h.changed_nanoseconds = st.st_ctim.tv_nsec;
+        return h;
+    }
+
+    bool same_file(const header &a, const header &b) {
+        return memcmp(a.magic, b.magic, sizeof(MAGIC)) == 0 && a.version == b.version && a.width == b.width &&
+               a.file_size == b.file_size && a.device == b.device && a.inode == b.inode &&
+               a.modified_seconds == b.modified_seconds && a.modified_nanoseconds == b.modified_nanoseconds &&
+               a.changed_seconds == b.changed_seconds && a.changed_nanoseconds == b.changed_nanoseconds;
+    }
+
+    std::size_t index_bytes(const header &h) {
+        return sizeof(header) + (std::size_t) h.file_size * h.width * (h.with_lcp ? 2 : 1);
+    }
+
+    template<typename Index>
+    void build_arrays(const char *text, std::size_t n, char *arrays, bool with_lcp) {
+        auto *sa = (Index *) arrays;
+        build_suffix_array<Index>((const unsigned char *) text, (Index) n, sa);
+        if (with_lcp) build_lcp_array<Index>((const unsigned char *) text, (Index) n, sa, sa + n);
+    }
+
+    // Maps the new index file, fills it and writes it out.
+    void write_index(int fd, const header &h, const char *text) {
+        std::size_t bytes = index_bytes(h);
+        if (ftruncate(fd, (off_t) bytes) != 0) throw_errno(errno, "ftruncate");
+        void *mapping = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapping == MAP_FAILED) throw_errno(errno, "mmap");
+        try {
+            char *arrays = (char *) mapping + sizeof(header);
+            if (h.width == 4) {
+                build_arrays<std::uint32_t>(text, h.file_size, arrays, h.with_lcp);
+            } else {
+                build_arrays<std::uint64_t>(text, h.file_size, arrays, h.with_lcp);
+            }
+        } catch (...) {
+            munmap(mapping, bytes);
+            throw;
+        }
+        memcpy(mapping, &h, sizeof(h));
+        munmap(mapping, bytes);
+        if (fsync(fd) != 0) throw_errno(errno, "fsync");
+    }
+}
+
+std::string suffix_index::path_for(const std::string &path) {
+    return path + ".sa";
+}
+
+void suffix_index::build(const std::string &path, bool with_lcp) {
+    input_file in(path.c_str());
+    struct stat st;
+    if (fstat(in.fd(), &st) != 0) throw_errno(errno, path);
+    if (!S_ISREG(st.st_mode)) throw std::invalid_argument("Can't index " + path + ": not a regular file");
+    header h = describe(st);
+    h.with_lcp = with_lcp;
+    std::unique_ptr<mapped_file> text;
+    if (st.st_size > 0) text.reset(new mapped_file(in));
+
+    std::string target = path_for(path);
+    std::string temporary = target + ".tmp";
+    int fd = ::open(temporary.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) throw_errno(errno, temporary);
+    try {
+        write_index(fd, h, text ? text->data() : nullptr);
+        // An index of what the file was halfway through a change would look up the wrong bytes.
+        if (fstat(in.fd(), &st) != 0) throw_errno(errno, path);
+        if (!same_file(h, describe(st))) throw std::invalid_argument(path + " changed while it was indexed");
+        if (close(fd) != 0) {
+            fd = -1;
+            throw_errno(errno, temporary);
+        }
+        fd = -1;
+        if (rename(temporary.c_str(), target.c_str()) != 0) throw_errno(errno, target);
+    } catch (...) {
+        if (fd >= 0) close(fd);
+        unlink(temporary.c_str());
+        throw;
+    }
+}
+
+std::unique_ptr<suffix_index> suffix_index::open(const std::string &path, const input_file &file,
+                                                 const mapped_file &text) {
+    int fd = ::open(path_for(path).c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return nullptr;
+    struct stat st, index_st;
+    void *mapping = MAP_FAILED;
+    std::size_t bytes = 0;
+    if (fstat(file.fd(), &st) == 0 && fstat(fd, &index_st) == 0 && (std::size_t) index_st.st_size >= sizeof(header)) {
+        bytes = (std::size_t) index_st.st_size;
+        mapping = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (mapping == MAP_FAILED) return nullptr;
+
+    header h;
+    memcpy(&h, mapping, sizeof(h));
+    header expected = describe(st);
+    expected.with_lcp = h.with_lcp;
+    if (!same_file(h, expected) || h.with_lcp > 1 || text.size() != h.file_size || bytes != index_bytes(h)) {
+        munmap(mapping, bytes);
+        return nullptr;
+    }
+    // A lookup touches a few scattered pages of the index and then one run of it.
+    madvise(mapping, bytes, MADV_RANDOM);
+    return std::unique_ptr<suffix_index>(new suffix_index(mapping, bytes, text, h.width, h.with_lcp));
+}
+
+suffix_index::suffix_index(void *mapping, std::size_t bytes, const mapped_file &text, std::size_t width,
+                           bool with_lcp)
+        : _mapping(mapping), _bytes(bytes), _text(text.data()), _size(text.size()), _width(width) {
+    _suffixes = (const char *) mapping + sizeof(header);
+    _lcp = with_lcp ? _suffixes + _size * _width : nullptr;
+}
+
+suffix_index::~suffix_index() {
+    munmap(_mapping, _bytes);
+}
+
+std::size_t suffix_index::entry(const char *array, std::size_t k) const {
+    if (_width == 4) return ((const std::uint32_t *) array)[k];
+    return (std::size_t) ((const std::uint64_t *) array)[k];
+}
+
+int suffix_index::compare(std::size_t pos, const std::string &word) const {
+    std::size_t length = std::min(word.size(), _size - pos);
+    int order = memcmp(_text + pos, word.data(), length);
+    if (order != 0) return order;
+    // A suffix shorter than the word sorts before it.
+    return length < word.size() ? -1 : 0;
+}
+
+void suffix_index::range(const std::string &word, std::size_t &first, std::size_t &last, bool listing) const {
+    std::size_t low = 0, high = _size;
+    while (low < high) {
+        std::size_t middle = low + (high - low) / 2;
+        if (compare(entry(_suffixes, middle), word) < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    first = last = low;
+    if (first == _size || compare(entry(_suffixes, first), word) != 0) return;
+
+    if (listing && _lcp) {
+        // The occurrences are read anyway, so walk them instead of searching for their end.
+        last = first + 1;
+        while (last < _size && entry(_lcp, last) >= word.size()) last++;
+        return;
+    }
+    low = first + 1;
+    high = _size;
+    while (low < high) {
+        std::size_t middle = low + (high - low) / 2;
+        if (compare(entry(_suffixes, middle), word) == 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    last = low;
+}
+
+std::size_t suffix_index::count(const std::string &word) const {
+    std::size_t first, last;
+    range(word, first, last, false);
+    return last - first;
+}
+
+void suffix_index::find(const std::string &word, std::vector<match> &out, std::size_t max) const {
+    std::size_t first, last;
+    range(word, first, last, true);
+    std::size_t start = out.size();
+    out.reserve(start + (last - first));
+    for (std::size_t k = first; k < last; k++) {
+        out.push_back({0, entry(_suffixes, k)});
+    }
+    auto by_offset = [](const match &a, const match &b) { return a.offset < b.offset; };
+    if (max < last - first) {
+        std::nth_element(out.begin() + start, out.begin() + start + max, out.end(), by_offset);
+        out.resize(start + max);
+    }
+    std::sort(out.begin() + start, out.end(), by_offset);
+}
@@ -0,0 +1,63 @@
+#ifndef SEARCH_SUFFIX_INDEX_H
+#define SEARCH_SUFFIX_INDEX_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+#include "input.h"
+#include "matcher.h"
+
+// Suffix array of a file, saved beside it in <file>.sa, so that looking up a word takes a binary
+// search instead of a scan: O(|word| log n) to find the occurrences and O(occ) to list them,
+// plus sorting them into file order. The index remembers the size, inode, and modification and
+// change times of the file it was built from and isn't used once any of them changes; a file
+// rewritten with its old size and modification time still gets a new change time.
+struct suffix_index {
+public:
+    static std::string path_for(const std::string &path);
+
+    // Builds the index of the file at path, with the LCP array if asked, which then bounds the
+    // occurrences without a second binary search. The index is written to a temporary file and
+    // renamed into place. Throws std::system_error if a file can't be read or written.
+    static void build(const std::string &path, bool with_lcp);
+
+    // Maps the index of the file at path, which `file` has open and `text` maps. Returns nullptr
+    // if there is no index, or it is out of date or damaged.
+    static std::unique_ptr<suffix_index> open(const std::string &path, const input_file &file,
+                                              const mapped_file &text);
+
+    suffix_index(const suffix_index &) = delete;
+
+    suffix_index &operator=(const suffix_index &) = delete;
+
+    ~suffix_index();
+
+    std::size_t count(const std::string &word) const;
+
+    // Appends the first `max` occurrences of word in file order.
+    void find(const std::string &word, std::vector<match> &out, std::size_t max = SIZE_MAX) const;
+
+private:
+    void *_mapping;
+    std::size_t _bytes;
+    const char *_text;
+    std::size_t _size;
+    std::size_t _width;
+    const char *_suffixes;
+    // nullptr if the index was built without it.
+    const char *_lcp;
+
+    suffix_index(void *mapping, std::size_t bytes, const mapped_file &text, std::size_t width, bool with_lcp);
+
+    std::size_t entry(const char *array, std::size_t k) const;
+
+    // Compares the suffix at pos with word, as equal if it starts with it.
+    int compare(std::size_t pos, const std::string &word) const;
+
+    // Slots [first, last) of the suffix array hold the suffixes that start with word. When they
+    // are to be listed, the LCP array bounds them as it goes.
+    void range(const std::string &word, std::size_t &first, std::size_t &last, bool listing) const;
+};
+
+#endif //SEARCH_SUFFIX_INDEX_H
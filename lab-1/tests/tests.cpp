@@ -0,0 +1,72 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "gtest/gtest.h"
+#include "../input.h"
+#include "../suffix_index.h"
+
+namespace {
+    void write_file(const std::string &path, const std::string &contents, int flags) {
+        int fd = open(path.c_str(), O_WRONLY | O_CREAT | flags, 0644);
+        ASSERT_GE(fd, 0);
+        ASSERT_EQ((ssize_t) contents.size(), write(fd, contents.data(), contents.size()));
+        close(fd);
+    }
+
+    bool has_index(const std::string &path) {
+        input_file file(path.c_str());
+        mapped_file text(file);
+        return suffix_index::open(path, file, text) != nullptr;
+    }
+}
+
+TEST(suffix_index, finds_words) {
+    std::string path = "/tmp/suffix_index_test." + std::to_string(getpid());
+    write_file(path, "abracadabra", O_TRUNC);
+    suffix_index::build(path, true);
+
+    input_file file(path.c_str());
+    mapped_file text(file);
+    auto index = suffix_index::open(path, file, text);
+    ASSERT_NE(nullptr, index);
+    ASSERT_EQ(2, index->count("abra"));
+    ASSERT_EQ(0, index->count("abraz"));
+    std::vector<match> found;
+    index->find("a", found);
+    std::vector<std::size_t> offsets;
+    for (auto &m : found) {
+        offsets.push_back(m.offset);
+    }
+    ASSERT_EQ(std::vector<std::size_t>({0, 3, 5, 7, 10}), offsets);
+
+    unlink(path.c_str());
+    unlink(suffix_index::path_for(path).c_str());
+}
+
+TEST(suffix_index, rewrite_with_old_mtime_is_stale) {
+    std::string path = "/tmp/suffix_index_stale." + std::to_string(getpid());
+    write_file(path, "hello world", O_TRUNC);
+    suffix_index::build(path, false);
+    ASSERT_TRUE(has_index(path));
+
+    struct stat before;
+    ASSERT_EQ(0, stat(path.c_str(), &before));
+    // Same size, same inode, and the modification time put back.
+    write_file(path, "jello world", 0);
+    struct timespec times[2] = {before.st_atim, before.st_mtim};
+    ASSERT_EQ(0, utimensat(AT_FDCWD, path.c_str(), times, 0));
+    struct stat after;
+    ASSERT_EQ(0, stat(path.c_str(), &after));
+    ASSERT_EQ(before.st_ino, after.st_ino);
+    ASSERT_EQ(before.st_size, after.st_size);
+    ASSERT_EQ(before.st_mtim.tv_sec, after.st_mtim.tv_sec);
+    ASSERT_EQ(before.st_mtim.tv_nsec, after.st_mtim.tv_nsec);
+
+    ASSERT_FALSE(has_index(path));
+
+    unlink(path.c_str());
+    unlink(suffix_index::path_for(path).c_str());
+}
@@ -0,0 +1,99 @@
+#include <utility>
+#include "thread_pool.h"
+
+namespace {
+    // Pool and queue of the worker running on this thread.
+    thread_local const thread_pool *current_pool = nullptr;
+    thread_local std::size_t current_queue = 0;
+}
+
+thread_pool::thread_pool(std::size_t threads) : _pending(0), _queued(0), _next_queue(0), _stopping(false) {
+    if (threads == 0) threads = 1;
+    for (std::size_t i = 0; i < threads; i++) {
+        _queues.emplace_back(new queue());
+    }
+    for (std::size_t i = 0; i < threads; i++) {
+        _workers.emplace_back([this, i] { work(i); });
+    }
+}
+
+thread_pool::~thread_pool() {
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        _stopping = true;
+    }
+    _wake.notify_all();
+    for (auto &worker : _workers) {
+        worker.join();
+    }
+}
+
+std::size_t thread_pool::size() const {
+    return _workers.size();
+}
+
+void thread_pool::submit(std::function<void()> task) {
+    std::size_t target;
+    {
+        // Counted before it is queued, so that _queued never runs behind the deques.
+        std::lock_guard<std::mutex> guard(_lock);
+        _pending++;
+        _queued++;
+        target = current_pool == this ? current_queue : _next_queue++ % _queues.size();
+    }
+    {
+        std::lock_guard<std::mutex> guard(_queues[target]->lock);
+        _queues[target]->tasks.push_back(std::move(task));
+    }
+    _wake.notify_one();
+}
+
+void thread_pool::wait() {
+    std::unique_lock<std::mutex> guard(_lock);
+    _idle.wait(guard, [this] { return _pending == 0; });
+}
+
+bool thread_pool::take(std::size_t self, std::function<void()> &task) {
+    {
+        queue &own = *_queues[self];
+        std::lock_guard<std::mutex> guard(own.lock);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    for (std::size_t k = 1; k < _queues.size(); k++) {
+        queue &victim = *_queues[(self + k) % _queues.size()];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void thread_pool::work(std::size_t self) {
+    current_pool = this;
+    current_queue = self;
+    while (true) {
+        std::function<void()> task;
+        if (take(self, task)) {
+            {
+                std::lock_guard<std::mutex> guard(_lock);
+                _queued--;
+            }
+            task();
+            std::lock_guard<std::mutex> guard(_lock);
+            if (--_pending == 0) _idle.notify_all();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> guard(_lock);
+        // A task counted in _queued but not pushed yet is only a moment away: try again.
+        _wake.wait(guard, [this] { return _stopping || _queued > 0; });
+        if (_stopping && _queued == 0) return;
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef SEARCH_THREAD_POOL_H
+#define SEARCH_THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing pool. Every worker owns a deque: tasks a worker submits go to the back of its
+// own deque and it pops from the back, so a directory walk goes depth first and stays in cache;
+// an idle worker steals from the front of the others, taking the oldest, largest pieces of work.
+// Tasks submitted from outside the pool are spread over the workers.
+struct thread_pool {
+public:
+    explicit thread_pool(std::size_t threads = std::thread::hardware_concurrency());
+
+    thread_pool(const thread_pool &) = delete;
+
+    thread_pool &operator=(const thread_pool &) = delete;
+
+    // Runs the tasks still queued, then joins the workers.
+    ~thread_pool();
+
+    std::size_t size() const;
+
+    // Tasks must not throw.
+    void submit(std::function<void()> task);
+
+    // Blocks until every submitted task, including those submitted by tasks, has finished.
+    void wait();
+
+private:
+    struct queue {
+        std::mutex lock;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<queue>> _queues;
+    std::mutex _lock;
+    std::condition_variable _wake;
+    std::condition_variable _idle;
+    // Tasks submitted and not finished, and those of them not started yet.
+    std::size_t _pending;
+    std::size_t _queued;
+    std::size_t _next_queue;
+    bool _stopping;
+    std::vector<std::thread> _workers;
+
+    bool take(std::size_t self, std::function<void()> &task);
+
+    void work(std::size_t self);
+};
+
+#endif //SEARCH_THREAD_POOL_H
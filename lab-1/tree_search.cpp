@@ -0,0 +1,197 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <system_error>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "input.h"
+#include "parallel_search.h"
+#include "tree_search.h"
+
+namespace {
+    // Reads the whole file with as few read() calls as it takes; returns false on error.
+    bool read_file(int fd, std::size_t size_hint, std::vector<char> &buffer) {
+        buffer.resize(size_hint + 1);
+        std::size_t length = 0;
+        while (true) {
+            if (length == buffer.size()) buffer.resize(buffer.size() * 2);
+            ssize_t got = read(fd, buffer.data() + length, buffer.size() - length);
+            if (got < 0 && errno == EINTR) continue;
+            if (got < 0) return false;
+            if (got == 0) break;
+            length += (std::size_t) got;
+        }
+        buffer.resize(length);
+        return true;
+    }
+
+    // Chunks of one large file; whichever chunk finishes last prints them all.
+    struct file_chunks {
+        std::string path;
+        std::unique_ptr<mapped_file> mapping;
+        std::vector<std::vector<match>> found;
+        std::atomic<std::size_t> left;
+    };
+}
+
+tree_search::tree_search(const matcher &m, const options &opts, thread_pool &pool, output_buffer &out)
+        : _matcher(m), _opts(opts), _pool(pool), _out(out), _failed(false) {}
+
+void tree_search::add(const std::string &path) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        report_error(path, errno);
+        return;
+    }
+    if (S_ISDIR(st.st_mode)) {
+        _pool.submit([this, path] { walk(path); });
+    } else {
+        _pool.submit([this, path] { search_file(path); });
+    }
+}
+
+bool tree_search::wait() {
+    _pool.wait();
+    return !_failed;
+}
+
+void tree_search::walk(const std::string &dir) {
+    DIR *d = opendir(dir.c_str());
+    if (!d) {
+        report_error(dir, errno);
+        return;
+    }
+    std::string prefix = dir.back() == '/' ? dir : dir + "/";
+    while (dirent *entry = readdir(d)) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+        std::string path = prefix + entry->d_name;
+
+        unsigned char type = entry->d_type;
+        if (type == DT_UNKNOWN) {
+            struct stat st;
+            if (lstat(path.c_str(), &st) != 0) {
+                report_error(path, errno);
+                continue;
+            }
+            type = S_ISDIR(st.st_mode) ? DT_DIR : S_ISREG(st.st_mode) ? DT_REG : DT_UNKNOWN;
+        }
+        if (type == DT_DIR) {
+            _pool.submit([this, path] { walk(path); });
+        } else if (type == DT_REG) {
+            _pool.submit([this, path] { search_file(path); });
+        }
+    }
+    closedir(d);
+}
+
+void tree_search::search_file(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        report_error(path, errno);
+        return;
+    }
+    input_file in(fd);
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        report_error(path, errno);
+        return;
+    }
+    if (!S_ISREG(st.st_mode)) return;
+
+    try {
+        auto size = (std::size_t) st.st_size;
+        if (size >= 2 * CHUNK_SIZE && _matcher.splittable()) {
+            search_chunks(path, in);
+            return;
+        }
+
+        std::vector<match> matches;
+        if (size < READ_LIMIT) {
+            thread_local std::vector<char> buffer;
+            if (!read_file(fd, size, buffer)) {
+                report_error(path, errno);
+                return;
+            }
+            _matcher.find(buffer.data(), buffer.size(), 0, buffer.size(), matches, _opts.max_matches);
+        } else if (size > 0) {
+            mapped_file mapping(in);
+            _matcher.find(mapping.data(), mapping.size(), 0, mapping.size(), matches, _opts.max_matches);
+        }
+        print(path, matches);
+    } catch (const std::system_error &e) {
+        report_error(path, e.code().value());
+    } catch (const std::bad_alloc &) {
+        report_error(path, ENOMEM);
+    }
+}
+
+void tree_search::search_chunks(const std::string &path, const input_file &file) {
+    auto chunks = std::make_shared<file_chunks>();
+    chunks->path = path;
+    chunks->mapping.reset(new mapped_file(file));
+
+    std::size_t size = chunks->mapping->size();
+    std::size_t count = (size + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    chunks->found.resize(count);
+    chunks->left = count;
+    for (std::size_t k = 0; k < count; k++) {
+        _pool.submit([this, chunks, k, size] {
+            std::size_t begin = k * CHUNK_SIZE;
+            std::size_t end = std::min(begin + CHUNK_SIZE, size);
+            try {
+                _matcher.find(chunks->mapping->data(), size, begin, end, chunks->found[k], _opts.max_matches);
+            } catch (const std::bad_alloc &) {
+                report_error(chunks->path, ENOMEM);
+            }
+            if (chunks->left.fetch_sub(1) != 1) return;
+
+            std::vector<match> all;
+            for (auto &part : chunks->found) {
+                all.insert(all.end(), part.begin(), part.end());
+            }
+            print(chunks->path, all);
+        });
+    }
+}
+
+void tree_search::print(const std::string &path, std::vector<match> &matches) {
+    if (matches.size() > _opts.max_matches) matches.resize(_opts.max_matches);
+    std::string text;
+    if (_opts.count_only) {
+        // Like grep -c, files without matches are listed too.
+        text += path;
+        text += ':';
+        append_decimal(text, matches.size());
+        text += '\n';
+    } else {
+        for (const auto &m : matches) {
+            text += path;
+            text += ':';
+            if (_matcher.multi_pattern()) {
+                append_decimal(text, m.pattern);
+                text += ' ';
+            }
+            append_decimal(text, m.offset);
+            if (_matcher.approximate()) {
+                text += ' ';
+                append_decimal(text, m.errors);
+            }
+            text += '\n';
+        }
+    }
+    if (text.empty()) return;
+
+    std::lock_guard<std::mutex> guard(_output_lock);
+    _out.write(text.data(), text.size());
+}
+
+void tree_search::report_error(const std::string &path, int error) {
+    _failed = true;
+    std::lock_guard<std::mutex> guard(_output_lock);
+    fprintf(stderr, "%s: %s\n", path.c_str(), strerror(error));
+}
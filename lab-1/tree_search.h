@@ -0,0 +1,53 @@
+#ifndef SEARCH_TREE_SEARCH_H
+#define SEARCH_TREE_SEARCH_H
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "input.h"
+#include "matcher.h"
+#include "options.h"
+#include "output.h"
+#include "thread_pool.h"
+
+// Searches files and whole directory trees on a pool. Directories are listed by pool tasks, so
+// the walk itself runs in parallel. Each match prints as `path:offset` (`path:pattern_id offset`
+// with several patterns), or each file as `path:count` with --count; --max applies to each file.
+// A file's matches are printed together and in order, files in no particular order. Symbolic
+// links inside directories are not followed, and only regular files are searched.
+struct tree_search {
+public:
+    // Files below this size are read with one read(); larger ones are mapped.
+    static const std::size_t READ_LIMIT = std::size_t(1) << 20;
+
+    tree_search(const matcher &m, const options &opts, thread_pool &pool, output_buffer &out);
+
+    // A file or directory named on the command line; symbolic links to them are followed.
+    void add(const std::string &path);
+
+    // Waits for the search to finish. Returns false if some file or directory couldn't be read;
+    // those were reported on stderr.
+    bool wait();
+
+private:
+    const matcher &_matcher;
+    const options &_opts;
+    thread_pool &_pool;
+    output_buffer &_out;
+    std::mutex _output_lock;
+    std::atomic<bool> _failed;
+
+    void walk(const std::string &dir);
+
+    void search_file(const std::string &path);
+
+    void search_chunks(const std::string &path, const input_file &file);
+
+    void print(const std::string &path, std::vector<match> &matches);
+
+    void report_error(const std::string &path, int error);
+};
+
+#endif //SEARCH_TREE_SEARCH_H
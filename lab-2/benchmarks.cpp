@@ -0,0 +1,517 @@
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <vector>
+#include "benchmark/benchmark.h"
+#include "vector.h"
+#include "vector.cpp"
+#include "simd.h"
+#include "simd.cpp"
+#include "thread_pool.h"
+#include "thread_pool.cpp"
+#include "parallel.h"
+#include "parallel.cpp"
+#include "soa_vector.h"
+#include "soa_vector.cpp"
+#include "vector_stats.h"
+#include "vector_stats.cpp"
+
+template<typename Vector>
+void BM_grow_int(benchmark::State &state) {
+    const auto n = (std::size_t) state.range(0);
+    for (auto _ : state) {
+        Vector v;
+        for (std::size_t i = 0; i < n; i++) {
+            v.push_back((int) i);
+        }
+        benchmark::DoNotOptimize(v.data());
+    }
+    state.SetBytesProcessed((int64_t) (state.iterations() * n * sizeof(int)));
+}
+
+BENCHMARK_TEMPLATE(BM_grow_int, vector<int>)->Range(1 << 10, 1 << 26)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_grow_int, std::vector<int>)->Range(1 << 10, 1 << 26)->Unit(benchmark::kMillisecond);
+
+// Value-initializing resize of a large buffer: fresh pages are left to the kernel's zero pages.
+template<typename Vector>
+void BM_resize_zeroed(benchmark::State &state) {
+    const auto n = (std::size_t) state.range(0);
+    for (auto _ : state) {
+        Vector v;
+        v.resize(n);
+        benchmark::DoNotOptimize(v.data());
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_resize_zeroed, vector<int>)->Arg(1 << 25)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_resize_zeroed, std::vector<int>)->Arg(1 << 25)->Unit(benchmark::kMillisecond);
+
+template<typename T>
+vector<T> iota_vector(std::size_t n) {
+    vector<T> v;
+    v.reserve(n);
+    for (std::size_t i = 0; i < n; i++) {
+        v.push_back((T) (i % 1000));
+    }
+    return v;
+}
+
+// Argument 0 is the std:: algorithm, 1..4 are simd::isa levels (scalar, sse2, avx2, avx512).
+template<typename T>
+void BM_scan_find(benchmark::State &state) {
+    auto v = iota_vector<T>(1 << 20);
+    v.push_back((T) 5000);
+    const T *data = v.data();
+    if (state.range(0) > 0) simd::use_isa((simd::isa) (state.range(0) - 1));
+    for (auto _ : state) {
+        std::size_t pos = state.range(0) == 0 ? std::find(data, data + v.size(), (T) 5000) - data
+                                              : simd::find(v, (T) 5000);
+        benchmark::DoNotOptimize(pos);
+    }
+    simd::use_isa(simd::detected_isa());
+    state.SetBytesProcessed((int64_t) (state.iterations() * v.size() * sizeof(T)));
+}
+
+template<typename T>
+void BM_scan_count(benchmark::State &state) {
+    auto v = iota_vector<T>(1 << 20);
+    const T *data = v.data();
+    if (state.range(0) > 0) simd::use_isa((simd::isa) (state.range(0) - 1));
+    for (auto _ : state) {
+        std::size_t cnt = state.range(0) == 0 ? std::count(data, data + v.size(), (T) 7) : simd::count(v, (T) 7);
+        benchmark::DoNotOptimize(cnt);
+    }
+    simd::use_isa(simd::detected_isa());
+    state.SetBytesProcessed((int64_t) (state.iterations() * v.size() * sizeof(T)));
+}
+
+template<typename T>
+void BM_scan_min_element(benchmark::State &state) {
+    auto v = iota_vector<T>(1 << 20);
+    const T *data = v.data();
+    if (state.range(0) > 0) simd::use_isa((simd::isa) (state.range(0) - 1));
+    for (auto _ : state) {
+        std::size_t pos = state.range(0) == 0 ? std::min_element(data, data + v.size()) - data
+                                              : simd::min_element(v);
+        benchmark::DoNotOptimize(pos);
+    }
+    simd::use_isa(simd::detected_isa());
+    state.SetBytesProcessed((int64_t) (state.iterations() * v.size() * sizeof(T)));
+}
+
+template<typename T>
+void BM_scan_sum(benchmark::State &state) {
+    auto v = iota_vector<T>(1 << 20);
+    const T *data = v.data();
+    if (state.range(0) > 0) simd::use_isa((simd::isa) (state.range(0) - 1));
+    for (auto _ : state) {
+        T sum = state.range(0) == 0 ? std::accumulate(data, data + v.size(), T()) : simd::sum(v);
+        benchmark::DoNotOptimize(sum);
+    }
+    simd::use_isa(simd::detected_isa());
+    state.SetBytesProcessed((int64_t) (state.iterations() * v.size() * sizeof(T)));
+}
+
+template<typename T>
+void BM_scan_dot(benchmark::State &state) {
+    auto a = iota_vector<T>(1 << 20), b = iota_vector<T>(1 << 20);
+    if (state.range(0) > 0) simd::use_isa((simd::isa) (state.range(0) - 1));
+    for (auto _ : state) {
+        T dot = state.range(0) == 0 ? std::inner_product(a.data(), a.data() + a.size(), b.data(), T())
+                                    : simd::dot(a, b);
+        benchmark::DoNotOptimize(dot);
+    }
+    simd::use_isa(simd::detected_isa());
+    state.SetBytesProcessed((int64_t) (state.iterations() * 2 * a.size() * sizeof(T)));
+}
+
+template<typename T>
+void BM_scan_transform_max(benchmark::State &state) {
+    auto a = iota_vector<T>(1 << 20), b = iota_vector<T>(1 << 20), out = iota_vector<T>(1 << 20);
+    if (state.range(0) > 0) simd::use_isa((simd::isa) (state.range(0) - 1));
+    for (auto _ : state) {
+        if (state.range(0) == 0) {
+            std::transform(a.data(), a.data() + a.size(), b.data(), out.data(),
+                           [](T x, T y) { return std::max(x, y); });
+        } else {
+            simd::transform(a, b, out, simd::op::max);
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+    simd::use_isa(simd::detected_isa());
+    state.SetBytesProcessed((int64_t) (state.iterations() * 3 * a.size() * sizeof(T)));
+}
+
+#define BENCHMARK_SCAN(name) \
+    BENCHMARK_TEMPLATE(name, std::int32_t)->DenseRange(0, 4); \
+    BENCHMARK_TEMPLATE(name, float)->DenseRange(0, 4); \
+    BENCHMARK_TEMPLATE(name, double)->DenseRange(0, 4)
+
+BENCHMARK_SCAN(BM_scan_find);
+BENCHMARK_SCAN(BM_scan_count);
+BENCHMARK_SCAN(BM_scan_min_element);
+BENCHMARK_SCAN(BM_scan_sum);
+BENCHMARK_SCAN(BM_scan_dot);
+BENCHMARK_SCAN(BM_scan_transform_max);
+
+// Argument is the number of threads in the pool.
+void BM_parallel_sort(benchmark::State &state) {
+    thread_pool pool((std::size_t) state.range(0));
+    vector<int> src;
+    for (int i = 0; i < (1 << 23); i++) {
+        src.push_back((int) ((i * 2654435761u) >> 7));
+    }
+    for (auto _ : state) {
+        state.PauseTiming();
+        vector<int> v = src;
+        state.ResumeTiming();
+        parallel::sort(v, std::less<int>(), pool);
+        benchmark::DoNotOptimize(v.data());
+    }
+    state.SetItemsProcessed((int64_t) (state.iterations() * src.size()));
+}
+
+void BM_parallel_reduce(benchmark::State &state) {
+    thread_pool pool((std::size_t) state.range(0));
+    auto v = iota_vector<double>(1 << 25);
+    for (auto _ : state) {
+        double sum = parallel::reduce(v, 0.0, std::plus<double>(), false, pool);
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetBytesProcessed((int64_t) (state.iterations() * v.size() * sizeof(double)));
+}
+
+void BM_parallel_transform(benchmark::State &state) {
+    thread_pool pool((std::size_t) state.range(0));
+    auto v = iota_vector<float>(1 << 25);
+    vector<float> out;
+    for (auto _ : state) {
+        parallel::transform(v, out, [](float x) { return x * x + 1.0f; }, pool);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed((int64_t) (state.iterations() * v.size() * 2 * sizeof(float)));
+}
+
+void BM_parallel_inclusive_scan(benchmark::State &state) {
+    thread_pool pool((std::size_t) state.range(0));
+    auto v = iota_vector<long long>(1 << 24);
+    vector<long long> out;
+    for (auto _ : state) {
+        parallel::inclusive_scan(v, out, std::plus<long long>(), pool);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed((int64_t) (state.iterations() * v.size() * 2 * sizeof(long long)));
+}
+
+BENCHMARK(BM_parallel_sort)->RangeMultiplier(2)->Range(1, 32)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_parallel_reduce)->RangeMultiplier(2)->Range(1, 32)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_parallel_transform)->RangeMultiplier(2)->Range(1, 32)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_parallel_inclusive_scan)->RangeMultiplier(2)->Range(1, 32)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+struct particle {
+    float x, y, z;
+    float vx, vy, vz;
+    float mass;
+    std::int32_t id;
+};
+
+// Summing one field: the array of structs drags all 32 bytes of every particle through the cache,
+// the structure of arrays only the 4 bytes of the mass column.
+void BM_field_sum_aos(benchmark::State &state) {
+    vector<particle> v;
+    for (int i = 0; i < (1 << 22); i++) {
+        v.push_back(particle{0, 0, 0, 0, 0, 0, (float) (i % 100), i});
+    }
+    for (auto _ : state) {
+        float total = 0;
+        for (std::size_t i = 0; i < v.size(); i++) {
+            total += v[i].mass;
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed((int64_t) (state.iterations() * v.size()));
+}
+
+void BM_field_sum_soa(benchmark::State &state) {
+    soa_vector<float, float, float, float, float, float, float, std::int32_t> v;
+    for (int i = 0; i < (1 << 22); i++) {
+        v.emplace_back(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, (float) (i % 100), i);
+    }
+    for (auto _ : state) {
+        auto mass = v.column<6>();
+        benchmark::DoNotOptimize(simd::sum(mass.data(), mass.size()));
+    }
+    state.SetItemsProcessed((int64_t) (state.iterations() * v.size()));
+}
+
+BENCHMARK(BM_field_sum_aos)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_field_sum_soa)->Unit(benchmark::kMillisecond);
+
+// vector against std::vector over element types and operations. Besides time per operation,
+// every benchmark reports allocations and bytes allocated per iteration, and for vector the
+// bytes carried over by relocations (std::vector doesn't let us observe those).
+
+struct pod64 {
+    std::int64_t fields[8];
+};
+
+struct move_only {
+    std::unique_ptr<int> value;
+
+    move_only() = default;
+
+    explicit move_only(int v) : value(new int(v)) {}
+};
+
+template<typename T>
+T make_element(std::size_t i);
+
+template<>
+int make_element<int>(std::size_t i) { return (int) i; }
+
+template<>
+std::string make_element<std::string>(std::size_t i) { return "a string too long for SSO " + std::to_string(i); }
+
+template<>
+pod64 make_element<pod64>(std::size_t i) { return pod64{{(std::int64_t) i}}; }
+
+template<>
+move_only make_element<move_only>(std::size_t i) { return move_only((int) i); }
+
+std::size_t element_weight(int x) { return (std::size_t) x; }
+
+std::size_t element_weight(const std::string &x) { return x.size(); }
+
+std::size_t element_weight(const pod64 &x) { return (std::size_t) x.fields[0]; }
+
+std::size_t element_weight(const move_only &x) { return (std::size_t) *x.value; }
+
+struct allocation_counts {
+    std::uint64_t allocations;
+    std::uint64_t bytes_allocated;
+    // False when the vector doesn't say how much it moved, as with std::vector.
+    bool relocations_known;
+    std::uint64_t bytes_relocated;
+};
+
+// Every operator new in the benchmark, which covers std::vector's buffers and the heap
+// buffers of elements such as std::string. vector takes the buffers of trivially relocatable
+// types from malloc/mmap, and those are counted through counting_stats instead; the buffers of
+// other types come from operator new and are already counted here.
+std::atomic<std::uint64_t> heap_allocations{0};
+std::atomic<std::uint64_t> heap_bytes{0};
+
+void *operator new(std::size_t bytes) {
+    heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    heap_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    if (void *ptr = malloc(bytes ? bytes : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+// Not inlined, so that GCC doesn't see free() applied to the result of operator new.
+__attribute__((noinline)) void operator delete(void *ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept {
+    operator delete(ptr);
+}
+
+struct bench_site {};
+
+template<typename T>
+using lab_vector = vector<T, default_growth, counting_stats<bench_site>>;
+
+template<typename T>
+using std_vector = std::vector<T>;
+
+template<typename Vector>
+struct vector_traits;
+
+template<typename T>
+struct vector_traits<lab_vector<T>> {
+    static const bool buffers_from_operator_new =
+            !uses_raw_storage<T>::value && alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+    static allocation_counts read() {
+        auto &c = counting_stats<bench_site>::counters<T>();
+        if (buffers_from_operator_new) return allocation_counts{heap_allocations, heap_bytes, true, c.bytes_relocated};
+        return allocation_counts{c.allocations + heap_allocations, c.bytes_allocated + heap_bytes, true,
+                                 c.bytes_relocated};
+    }
+};
+
+template<typename T>
+struct vector_traits<std_vector<T>> {
+    static allocation_counts read() {
+        return allocation_counts{heap_allocations, heap_bytes, false, 0};
+    }
+};
+
+// Reports the allocation counters accumulated since construction, per benchmark iteration.
+template<typename Vector>
+struct allocation_report {
+    benchmark::State &state;
+    allocation_counts start;
+
+    explicit allocation_report(benchmark::State &s) : state(s), start(vector_traits<Vector>::read()) {}
+
+    ~allocation_report() {
+        allocation_counts end = vector_traits<Vector>::read();
+        auto per_iteration = benchmark::Counter::kAvgIterations;
+        state.counters["allocs"] = benchmark::Counter((double) (end.allocations - start.allocations), per_iteration);
+        state.counters["bytes_allocated"] = benchmark::Counter(
+                (double) (end.bytes_allocated - start.bytes_allocated), per_iteration);
+        double relocated = end.relocations_known ? (double) (end.bytes_relocated - start.bytes_relocated)
+                                                 : std::numeric_limits<double>::quiet_NaN();
+        state.counters["bytes_relocated"] = benchmark::Counter(relocated, per_iteration);
+    }
+};
+
+template<typename Vector>
+Vector filled_vector(std::size_t n) {
+    Vector v;
+    v.reserve(n);
+    for (std::size_t i = 0; i < n; i++) {
+        v.push_back(make_element<typename Vector::value_type>(i));
+    }
+    return v;
+}
+
+// Argument 1 reserves the final size first.
+template<typename Vector>
+void BM_push_back(benchmark::State &state) {
+    const std::size_t n = 1 << 12;
+    allocation_report<Vector> report(state);
+    for (auto _ : state) {
+        Vector v;
+        if (state.range(0)) v.reserve(n);
+        for (std::size_t i = 0; i < n; i++) {
+            v.push_back(make_element<typename Vector::value_type>(i));
+        }
+        benchmark::DoNotOptimize(v.data());
+    }
+    state.SetItemsProcessed((int64_t) (state.iterations() * n));
+}
+
+// Pushes and pops around a full buffer, where a growth policy without hysteresis would
+// reallocate on every step.
+template<typename Vector>
+void BM_push_pop_oscillation(benchmark::State &state) {
+    const std::size_t n = 1 << 10;
+    Vector v = filled_vector<Vector>(n);
+    allocation_report<Vector> report(state);
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < 16; i++) {
+            v.push_back(make_element<typename Vector::value_type>(i));
+        }
+        for (std::size_t i = 0; i < 16; i++) {
+            v.pop_back();
+        }
+        benchmark::DoNotOptimize(v.data());
+    }
+    state.SetItemsProcessed((int64_t) (state.iterations() * 32));
+}
+
+// Inserts an element and erases it again at the front (0), middle (1) or back (2).
+template<typename Vector>
+void BM_insert_erase(benchmark::State &state) {
+    const std::size_t n = 1 << 12;
+    Vector v = filled_vector<Vector>(n);
+    const std::size_t pos = state.range(0) == 0 ? 0 : state.range(0) == 1 ? n / 2 : n;
+    allocation_report<Vector> report(state);
+    for (auto _ : state) {
+        v.insert(v.begin() + pos, make_element<typename Vector::value_type>(pos));
+        v.erase(v.begin() + pos);
+        benchmark::DoNotOptimize(v.data());
+    }
+    state.SetItemsProcessed((int64_t) (state.iterations() * 2));
+}
+
+template<typename Vector>
+void BM_copy(benchmark::State &state) {
+    const Vector src = filled_vector<Vector>(1 << 12);
+    allocation_report<Vector> report(state);
+    for (auto _ : state) {
+        Vector copy(src);
+        benchmark::DoNotOptimize(copy.data());
+    }
+    state.SetItemsProcessed((int64_t) (state.iterations() * src.size()));
+}
+
+// Assigns over a vector that already has the room.
+template<typename Vector>
+void BM_assign(benchmark::State &state) {
+    const Vector src = filled_vector<Vector>(1 << 12);
+    Vector dst = filled_vector<Vector>(1 << 12);
+    allocation_report<Vector> report(state);
+    for (auto _ : state) {
+        dst = src;
+        benchmark::DoNotOptimize(dst.data());
+    }
+    state.SetItemsProcessed((int64_t) (state.iterations() * src.size()));
+}
+
+template<typename Vector>
+void BM_iterate(benchmark::State &state) {
+    const Vector v = filled_vector<Vector>(1 << 16);
+    allocation_report<Vector> report(state);
+    for (auto _ : state) {
+        std::size_t total = 0;
+        for (const auto &x : v) {
+            total += element_weight(x);
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed((int64_t) (state.iterations() * v.size()));
+}
+
+// Grows an empty vector to the size with value-initialized elements, then shrinks it back.
+template<typename Vector>
+void BM_resize(benchmark::State &state) {
+    const std::size_t n = 1 << 12;
+    allocation_report<Vector> report(state);
+    for (auto _ : state) {
+        Vector v;
+        v.resize(n);
+        benchmark::DoNotOptimize(v.data());
+        v.resize(n / 4);
+        benchmark::DoNotOptimize(v.data());
+    }
+    state.SetItemsProcessed((int64_t) (state.iterations() * n));
+}
+
+#define BENCHMARK_BOTH(name, T) \
+    BENCHMARK_TEMPLATE(name, lab_vector<T>); \
+    BENCHMARK_TEMPLATE(name, std_vector<T>)
+
+#define BENCHMARK_BOTH_ARGS(name, T, first, last) \
+    BENCHMARK_TEMPLATE(name, lab_vector<T>)->DenseRange(first, last); \
+    BENCHMARK_TEMPLATE(name, std_vector<T>)->DenseRange(first, last)
+
+#define BENCHMARK_CONTAINER(T) \
+    BENCHMARK_BOTH_ARGS(BM_push_back, T, 0, 1); \
+    BENCHMARK_BOTH(BM_push_pop_oscillation, T); \
+    BENCHMARK_BOTH_ARGS(BM_insert_erase, T, 0, 2); \
+    BENCHMARK_BOTH(BM_iterate, T); \
+    BENCHMARK_BOTH(BM_resize, T)
+
+BENCHMARK_CONTAINER(int);
+BENCHMARK_CONTAINER(std::string);
+BENCHMARK_CONTAINER(pod64);
+BENCHMARK_CONTAINER(move_only);
+
+// Copying needs a copyable element type.
+BENCHMARK_BOTH(BM_copy, int);
+BENCHMARK_BOTH(BM_copy, std::string);
+BENCHMARK_BOTH(BM_copy, pod64);
+BENCHMARK_BOTH(BM_assign, int);
+BENCHMARK_BOTH(BM_assign, std::string);
+BENCHMARK_BOTH(BM_assign, pod64);
+
+BENCHMARK_MAIN();
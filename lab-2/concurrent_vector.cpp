@@ -0,0 +1,125 @@
+#include <cassert>
+#include <new>
+#include <utility>
+#include "concurrent_vector.h"
+
+// Segment s holds FIRST_SEGMENT << s elements starting at index FIRST_SEGMENT * (2^s - 1).
+template<typename T>
+std::size_t concurrent_vector<T>::segment_of(std::size_t idx) {
+    std::size_t x = (idx >> FIRST_SEGMENT_BITS) + 1;
+    return 63 - __builtin_clzll(x);
+}
+
+template<typename T>
+std::size_t concurrent_vector<T>::segment_begin(std::size_t segment) {
+    return FIRST_SEGMENT * ((std::size_t(1) << segment) - 1);
+}
+
+template<typename T>
+std::size_t concurrent_vector<T>::segment_size(std::size_t segment) {
+    return FIRST_SEGMENT << segment;
+}
+
+template<typename T>
+concurrent_vector<T>::concurrent_vector() noexcept : _size(0) {
+    for (auto &s : _segments) {
+        s.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+template<typename T>
+concurrent_vector<T>::~concurrent_vector() {
+    std::size_t size = _size.load(std::memory_order_relaxed);
+    for (std::size_t s = 0; s < MAX_SEGMENTS; s++) {
+        slot *seg = _segments[s].load(std::memory_order_relaxed);
+        if (!seg) continue;
+
+        std::size_t begin = segment_begin(s);
+        for (std::size_t i = 0; i < segment_size(s) && begin + i < size; i++) {
+            if (seg[i].ready.load(std::memory_order_relaxed)) {
+                reinterpret_cast<T *>(&seg[i].value)->~T();
+            }
+        }
+        delete[] seg;
+    }
+}
+
+// Returns segment s, installing it if no thread has yet. The element storage is left
+// uninitialized and only the ready flags are cleared; the loser of a race frees its copy. If the
+// allocation throws, the segment stays uninstalled for a later push to retry.
+template<typename T>
+typename concurrent_vector<T>::slot *concurrent_vector<T>::segment(std::size_t s) {
+    slot *seg = _segments[s].load(std::memory_order_acquire);
+    if (seg) return seg;
+
+    auto *fresh = new slot[segment_size(s)];
+    for (std::size_t i = 0; i < segment_size(s); i++) {
+        fresh[i].ready.store(false, std::memory_order_relaxed);
+    }
+    if (_segments[s].compare_exchange_strong(seg, fresh, std::memory_order_acq_rel, std::memory_order_acquire)) {
+        return fresh;
+    }
+    delete[] fresh;
+    return seg;
+}
+
+template<typename T>
+typename concurrent_vector<T>::slot &concurrent_vector<T>::slot_at(std::size_t idx) const {
+    std::size_t s = segment_of(idx);
+    slot *seg = _segments[s].load(std::memory_order_acquire);
+    assert(seg);
+    return seg[idx - segment_begin(s)];
+}
+
+template<typename T>
+std::size_t concurrent_vector<T>::push_back(const T &item) {
+    return emplace_back(item);
+}
+
+template<typename T>
+std::size_t concurrent_vector<T>::push_back(T &&item) {
+    return emplace_back(std::move(item));
+}
+
+template<typename T>
+template<typename... Args>
+std::size_t concurrent_vector<T>::emplace_back(Args &&... args) {
+    std::size_t idx = _size.fetch_add(1, std::memory_order_relaxed);
+    std::size_t s = segment_of(idx);
+    slot &target = segment(s)[idx - segment_begin(s)];
+
+    new(&target.value) T(std::forward<Args>(args)...);
+    target.ready.store(true, std::memory_order_release);
+    return idx;
+}
+
+template<typename T>
+bool concurrent_vector<T>::published(std::size_t idx) const {
+    if (idx >= _size.load(std::memory_order_acquire)) return false;
+    slot *seg = _segments[segment_of(idx)].load(std::memory_order_acquire);
+    return seg && seg[idx - segment_begin(segment_of(idx))].ready.load(std::memory_order_acquire);
+}
+
+template<typename T>
+T &concurrent_vector<T>::operator[](std::size_t idx) {
+    slot &s = slot_at(idx);
+    assert(s.ready.load(std::memory_order_acquire));
+    return *reinterpret_cast<T *>(&s.value);
+}
+
+template<typename T>
+const T &concurrent_vector<T>::operator[](std::size_t idx) const {
+    slot &s = slot_at(idx);
+    assert(s.ready.load(std::memory_order_acquire));
+    return *reinterpret_cast<const T *>(&s.value);
+}
+
+template<typename T>
+std::size_t concurrent_vector<T>::size() const {
+    return _size.load(std::memory_order_acquire);
+}
+
+template<typename T>
+bool concurrent_vector<T>::empty() const {
+    return size() == 0;
+}
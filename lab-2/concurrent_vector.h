@@ -0,0 +1,72 @@
+#ifndef VECTOR_CONCURRENT_VECTOR_H
+#define VECTOR_CONCURRENT_VECTOR_H
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+// Append-only vector for many producer threads. Storage is a series of segments, each twice
+// as large as the one before, so elements never move: pointers and references stay valid
+// for the lifetime of the container.
+//
+// push_back/emplace_back claim an index with one fetch_add and are lock-free; a new segment is
+// installed with a CAS. An element becomes visible to readers (published) once constructed;
+// operator[] on a published index is wait-free. If a constructor or the allocation of a segment
+// throws, the claimed index stays unpublished forever.
+template<typename T>
+struct concurrent_vector {
+public:
+    concurrent_vector() noexcept;
+
+    concurrent_vector(const concurrent_vector &) = delete;
+
+    concurrent_vector &operator=(const concurrent_vector &) = delete;
+
+    // Must not run concurrently with anything else.
+    ~concurrent_vector();
+
+    std::size_t push_back(const T &item);
+
+    std::size_t push_back(T &&item);
+
+    template<typename... Args>
+    std::size_t emplace_back(Args &&... args);
+
+    // Whether element idx has been constructed. Once true it stays true.
+    bool published(std::size_t idx) const;
+
+    // idx must be published.
+    T &operator[](std::size_t idx);
+
+    const T &operator[](std::size_t idx) const;
+
+    // Indices claimed so far, including ones still being constructed.
+    std::size_t size() const;
+
+    bool empty() const;
+
+private:
+    static const std::size_t FIRST_SEGMENT_BITS = 3;
+    static const std::size_t FIRST_SEGMENT = std::size_t(1) << FIRST_SEGMENT_BITS;
+    static const std::size_t MAX_SEGMENTS = 64 - FIRST_SEGMENT_BITS;
+
+    struct slot {
+        std::atomic<bool> ready;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type value;
+    };
+
+    std::atomic<std::size_t> _size;
+    std::atomic<slot *> _segments[MAX_SEGMENTS];
+
+    static std::size_t segment_of(std::size_t idx);
+
+    static std::size_t segment_begin(std::size_t segment);
+
+    static std::size_t segment_size(std::size_t segment);
+
+    slot &slot_at(std::size_t idx) const;
+
+    slot *segment(std::size_t segment);
+};
+
+#endif //VECTOR_CONCURRENT_VECTOR_H
@@ -0,0 +1,268 @@
+#include <atomic>
+#include <utility>
+#include "vector.h"
+#include "cow_vector.h"
+
+template<typename T>
+const vector<T> &cow_vector<T>::items() const {
+    static const vector<T> empty_items;
+    return _buffer ? _buffer->items : empty_items;
+}
+
+// Makes the buffer owned by this object alone, copying it if it is shared.
+template<typename T>
+vector<T> &cow_vector<T>::mutable_items() {
+    if (!_buffer) {
+        _buffer = new buffer();
+    } else if (_buffer->refs.load(std::memory_order_acquire) != 1) {
+        auto *copy = new buffer(_buffer->items);
+        release();
+        _buffer = copy;
+    }
+    return _buffer->items;
+}
+
+template<typename T>
+vector<T> &cow_vector<T>::leaked_items() {
+    auto &own = mutable_items();
+    _buffer->shareable = false;
+    return own;
+}
+
+template<typename T>
+void cow_vector<T>::release() noexcept {
+    if (_buffer && _buffer->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete _buffer;
+    }
+    _buffer = nullptr;
+}
+
+template<typename T>
+cow_vector<T>::cow_vector() noexcept : _buffer(nullptr) {}
+
+template<typename T>
+cow_vector<T>::cow_vector(std::size_t initial_size) : _buffer(new buffer(vector<T>(initial_size))) {}
+
+template<typename T>
+cow_vector<T>::cow_vector(const cow_vector<T> &other) : _buffer(other._buffer) {
+    if (!_buffer) return;
+    if (_buffer->shareable) {
+        _buffer->refs.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        _buffer = new buffer(other._buffer->items);
+    }
+}
+
+template<typename T>
+cow_vector<T>::cow_vector(cow_vector<T> &&other) noexcept : _buffer(other._buffer) {
+    other._buffer = nullptr;
+}
+
+template<typename T>
+cow_vector<T>::cow_vector(const vector<T> &items) : _buffer(new buffer(items)) {}
+
+template<typename T>
+cow_vector<T>::cow_vector(vector<T> &&items) : _buffer(new buffer(std::move(items))) {}
+
+template<typename T>
+cow_vector<T> &cow_vector<T>::operator=(const cow_vector<T> &other) {
+    cow_vector<T> tmp(other);
+    swap(tmp);
+    return *this;
+}
+
+template<typename T>
+cow_vector<T> &cow_vector<T>::operator=(cow_vector<T> &&other) noexcept {
+    cow_vector<T> tmp(std::move(other));
+    swap(tmp);
+    return *this;
+}
+
+template<typename T>
+void cow_vector<T>::push_back(const T &item) {
+    mutable_items().push_back(item);
+}
+
+template<typename T>
+void cow_vector<T>::push_back(T &&item) {
+    mutable_items().push_back(std::move(item));
+}
+
+template<typename T>
+template<typename... Args>
+T &cow_vector<T>::emplace_back(Args &&... args) {
+    return leaked_items().emplace_back(std::forward<Args>(args)...);
+}
+
+template<typename T>
+void cow_vector<T>::pop_back() {
+    mutable_items().pop_back();
+}
+
+template<typename T>
+T &cow_vector<T>::back() {
+    return leaked_items().back();
+}
+
+template<typename T>
+const T &cow_vector<T>::back() const {
+    return items().back();
+}
+
+template<typename T>
+T &cow_vector<T>::operator[](std::size_t idx) {
+    return leaked_items()[idx];
+}
+
+template<typename T>
+const T &cow_vector<T>::operator[](std::size_t idx) const {
+    return items()[idx];
+}
+
+template<typename T>
+std::size_t cow_vector<T>::size() const {
+    return items().size();
+}
+
+template<typename T>
+bool cow_vector<T>::empty() const {
+    return items().empty();
+}
+
+template<typename T>
+bool cow_vector<T>::unique() const {
+    return !_buffer || _buffer->refs.load(std::memory_order_acquire) == 1;
+}
+
+template<typename T>
+void cow_vector<T>::make_shareable() {
+    if (_buffer) _buffer->shareable = true;
+}
+
+template<typename T>
+T *cow_vector<T>::data() {
+    return leaked_items().data();
+}
+
+template<typename T>
+const T *cow_vector<T>::data() const {
+    return items().data();
+}
+
+template<typename T>
+void cow_vector<T>::reserve(std::size_t new_capacity) {
+    mutable_items().reserve(new_capacity);
+}
+
+template<typename T>
+std::size_t cow_vector<T>::capacity() const {
+    return items().capacity();
+}
+
+template<typename T>
+void cow_vector<T>::shrink_to_fit() {
+    if (unique()) mutable_items().shrink_to_fit();
+}
+
+template<typename T>
+void cow_vector<T>::clear() {
+    release();
+}
+
+template<typename T>
+void cow_vector<T>::resize(std::size_t new_size, T value) {
+    mutable_items().resize(new_size, std::move(value));
+}
+
+template<typename T>
+cow_vector<T>::~cow_vector() {
+    release();
+}
+
+template<typename T>
+typename cow_vector<T>::iterator cow_vector<T>::begin() {
+    return leaked_items().begin();
+}
+
+template<typename T>
+typename cow_vector<T>::const_iterator cow_vector<T>::begin() const {
+    return items().begin();
+}
+
+template<typename T>
+typename cow_vector<T>::iterator cow_vector<T>::end() {
+    return leaked_items().end();
+}
+
+template<typename T>
+typename cow_vector<T>::const_iterator cow_vector<T>::end() const {
+    return items().end();
+}
+
+template<typename T>
+typename cow_vector<T>::reverse_iterator cow_vector<T>::rbegin() {
+    return reverse_iterator(end());
+}
+
+template<typename T>
+typename cow_vector<T>::const_reverse_iterator cow_vector<T>::rbegin() const {
+    return const_reverse_iterator(end());
+}
+
+template<typename T>
+typename cow_vector<T>::reverse_iterator cow_vector<T>::rend() {
+    return reverse_iterator(begin());
+}
+
+template<typename T>
+typename cow_vector<T>::const_reverse_iterator cow_vector<T>::rend() const {
+    return const_reverse_iterator(begin());
+}
+
+template<typename T>
+typename cow_vector<T>::iterator cow_vector<T>::insert(const_iterator pos, const T &value) {
+    return emplace(pos, value);
+}
+
+template<typename T>
+typename cow_vector<T>::iterator cow_vector<T>::insert(const_iterator pos, T &&value) {
+    return emplace(pos, std::move(value));
+}
+
+// Positions are turned into indices first: they may point into the shared buffer that is about to be copied.
+template<typename T>
+template<typename... Args>
+typename cow_vector<T>::iterator cow_vector<T>::emplace(const_iterator pos, Args &&... args) {
+    std::size_t idx = pos - items().begin();
+    auto &own = leaked_items();
+    return own.emplace(own.begin() + idx, std::forward<Args>(args)...);
+}
+
+template<typename T>
+typename cow_vector<T>::iterator cow_vector<T>::erase(const_iterator pos) {
+    return erase(pos, pos + 1);
+}
+
+template<typename T>
+typename cow_vector<T>::iterator cow_vector<T>::erase(const_iterator from, const_iterator to) {
+    std::size_t from_idx = from - items().begin();
+    std::size_t to_idx = to - items().begin();
+    auto &own = leaked_items();
+    return own.erase(own.begin() + from_idx, own.begin() + to_idx);
+}
+
+template<typename T>
+template<typename Iterator>
+cow_vector<T>::cow_vector(Iterator first, Iterator last) : _buffer(new buffer(vector<T>(first, last))) {}
+
+template<typename T>
+template<typename Iterator>
+void cow_vector<T>::assign(Iterator first, Iterator last) {
+    cow_vector<T> tmp(first, last);
+    swap(tmp);
+}
+
+template<typename T>
+void cow_vector<T>::swap(cow_vector<T> &other) noexcept {
+    std::swap(_buffer, other._buffer);
+}
@@ -0,0 +1,147 @@
+#ifndef VECTOR_COW_VECTOR_H
+#define VECTOR_COW_VECTOR_H
+
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include "vector.h"
+
+// vector whose copies share one reference-counted buffer until one of them is modified.
+// Every non-const accessor (including non-const begin/end/data/operator[]) makes the buffer
+// unique first. Those that hand out a reference, pointer or iterator also mark it unshareable,
+// since writes through it would reach later copies; copying such a vector copies its items until
+// make_shareable() is called or clear() or assignment gives it a new buffer. Copies living in
+// different threads may be used concurrently, as with shared_ptr.
+template<typename T>
+struct cow_vector {
+public:
+    cow_vector() noexcept;
+
+    explicit cow_vector(std::size_t initial_size);
+
+    cow_vector(const cow_vector<T> &other);
+
+    cow_vector(cow_vector<T> &&other) noexcept;
+
+    cow_vector(const vector<T> &items);
+
+    cow_vector(vector<T> &&items);
+
+    cow_vector &operator=(const cow_vector<T> &other);
+
+    cow_vector &operator=(cow_vector<T> &&other) noexcept;
+
+    void push_back(const T &item);
+
+    void push_back(T &&item);
+
+    template<typename... Args>
+    T &emplace_back(Args &&... args);
+
+    void pop_back();
+
+    T &back();
+
+    const T &back() const;
+
+    T &operator[](std::size_t idx);
+
+    const T &operator[](std::size_t idx) const;
+
+    std::size_t size() const;
+
+    bool empty() const;
+
+    bool unique() const;
+
+    // Promises that the references, pointers and iterators taken through non-const access so far
+    // won't be written through any more, so that later copies share the buffer again.
+    void make_shareable();
+
+    T *data();
+
+    const T *data() const;
+
+    void reserve(std::size_t new_capacity);
+
+    std::size_t capacity() const;
+
+    void shrink_to_fit();
+
+    void clear();
+
+    void resize(std::size_t new_size, T value = T());
+
+    ~cow_vector();
+
+    // Iterators:
+
+    typedef T *iterator;
+    typedef const T *const_iterator;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    iterator begin();
+
+    const_iterator begin() const;
+
+    iterator end();
+
+    const_iterator end() const;
+
+    reverse_iterator rbegin();
+
+    const_reverse_iterator rbegin() const;
+
+    reverse_iterator rend();
+
+    const_reverse_iterator rend() const;
+
+    iterator insert(const_iterator pos, const T &value);
+
+    iterator insert(const_iterator pos, T &&value);
+
+    template<typename... Args>
+    iterator emplace(const_iterator pos, Args &&... args);
+
+    iterator erase(const_iterator pos);
+
+    iterator erase(const_iterator from, const_iterator to);
+
+    template<typename Iterator>
+    cow_vector(Iterator first, Iterator last);
+
+    template<typename Iterator>
+    void assign(Iterator first, Iterator last);
+
+    void swap(cow_vector<T> &other) noexcept;
+
+    friend void swap(cow_vector<T> &a, cow_vector<T> &b) noexcept {
+        a.swap(b);
+    }
+
+private:
+    struct buffer {
+        std::atomic<std::size_t> refs;
+        // Only ever cleared, by the sole owner.
+        bool shareable;
+        vector<T> items;
+
+        buffer() : refs(1), shareable(true) {}
+        explicit buffer(const vector<T> &items) : refs(1), shareable(true), items(items) {}
+        explicit buffer(vector<T> &&items) : refs(1), shareable(true), items(std::move(items)) {}
+    };
+
+    buffer *_buffer;
+
+    const vector<T> &items() const;
+
+    vector<T> &mutable_items();
+
+    // mutable_items() for accessors whose result outlives the call.
+    vector<T> &leaked_items();
+
+    void release() noexcept;
+};
+
+#endif //VECTOR_COW_VECTOR_H
@@ -0,0 +1,248 @@
+#include <cassert>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "mapped_vector.h"
+
+namespace {
+    const char MAPPED_MAGIC[8] = {'V', 'E', 'C', 'T', 'O', 'R', '\0', '\0'};
+    const std::uint32_t MAPPED_VERSION = 1;
+
+    [[noreturn]] void throw_errno(const std::string &what) {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+
+    void write_all(int fd, const void *data, std::size_t bytes, const std::string &path) {
+        auto *from = (const char *) data;
+        while (bytes > 0) {
+            ssize_t written = write(fd, from, bytes);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                throw_errno("write " + path);
+            }
+            from += written;
+            bytes -= (std::size_t) written;
+        }
+    }
+
+    std::string directory_of(const std::string &path) {
+        std::size_t slash = path.rfind('/');
+        if (slash == std::string::npos) return ".";
+        return slash == 0 ? "/" : path.substr(0, slash);
+    }
+
+    void sync_directory(const std::string &directory) {
+        int fd = open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0) throw_errno("open " + directory);
+        if (fsync(fd) != 0) {
+            int error = errno;
+            close(fd);
+            throw std::system_error(error, std::generic_category(), "fsync " + directory);
+        }
+        close(fd);
+    }
+
+    void write_file(const char *path, const mapped_header &header, const void *data, std::size_t bytes) {
+        std::string target(path);
+        std::string directory = directory_of(target);
+        // A unique name, so that concurrent saves of the same path don't write into one file.
+        std::string temporary = directory + "/." + target.substr(target.rfind('/') + 1) + ".XXXXXX";
+        int fd = mkstemp(&temporary[0]);
+        if (fd < 0) throw_errno("mkstemp " + temporary);
+        try {
+            if (fchmod(fd, 0644) != 0) throw_errno("chmod " + temporary);
+            write_all(fd, &header, sizeof(header), temporary);
+            write_all(fd, data, bytes, temporary);
+            if (fsync(fd) != 0) throw_errno("fsync " + temporary);
+            if (close(fd) != 0) {
+                fd = -1;
+                throw_errno("close " + temporary);
+            }
+            fd = -1;
+            if (rename(temporary.c_str(), path) != 0) throw_errno("rename " + temporary);
+        } catch (...) {
+            if (fd >= 0) close(fd);
+            unlink(temporary.c_str());
+            throw;
+        }
+        sync_directory(directory);
+    }
+
+    // Maps the whole file read-only and returns its header.
+    const mapped_header &map_file(const char *path, void *&mapping, std::size_t &length) {
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) throw_errno(std::string("open ") + path);
+
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            int error = errno;
+            close(fd);
+            throw std::system_error(error, std::generic_category(), std::string("stat ") + path);
+        }
+        if ((std::size_t) st.st_size < sizeof(mapped_header)) {
+            close(fd);
+            throw std::runtime_error(std::string(path) + ": too short for a vector header");
+        }
+
+        length = (std::size_t) st.st_size;
+        mapping = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        int error = errno;
+        close(fd);
+        if (mapping == MAP_FAILED) {
+            mapping = nullptr;
+            throw std::system_error(error, std::generic_category(), std::string("mmap ") + path);
+        }
+        return *(const mapped_header *) mapping;
+    }
+}
+
+std::uint64_t mapped_checksum(const void *data, std::size_t bytes) {
+    const std::uint64_t prime = 1099511628211ull;
+    std::uint64_t hash = 14695981039346656037ull;
+    auto *from = (const unsigned char *) data;
+    // A word at a time; the per-byte loop is several times slower on large tables.
+    for (; bytes >= sizeof(std::uint64_t); bytes -= sizeof(std::uint64_t), from += sizeof(std::uint64_t)) {
+        std::uint64_t word;
+        memcpy(&word, from, sizeof(word));
+        hash = (hash ^ word) * prime;
+    }
+    for (; bytes > 0; bytes--, from++) {
+        hash = (hash ^ *from) * prime;
+    }
+    return hash;
+}
+
+template<typename T>
+void save(const T *data, std::size_t count, const char *path) {
+    static_assert(std::is_trivially_copyable<T>::value, "only trivially copyable types can be saved");
+
+    mapped_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAPPED_MAGIC, sizeof(header.magic));
+    header.version = MAPPED_VERSION;
+    header.element_size = sizeof(T);
+    header.element_align = alignof(T);
+    header.count = count;
+    header.checksum = mapped_checksum(data, count * sizeof(T));
+    write_file(path, header, data, count * sizeof(T));
+}
+
+template<typename T, typename... Policies>
+void save(const vector<T, Policies...> &v, const char *path) {
+    save(v.data(), v.size(), path);
+}
+
+template<typename T>
+mapped_vector<T>::mapped_vector() noexcept : _mapping(nullptr), _length(0), _storage(nullptr), _size(0) {}
+
+template<typename T>
+mapped_vector<T>::mapped_vector(const char *path) : mapped_vector() {
+    const mapped_header &header = map_file(path, _mapping, _length);
+
+    const char *problem = nullptr;
+    if (memcmp(header.magic, MAPPED_MAGIC, sizeof(header.magic)) != 0) {
+        problem = "not a saved vector";
+    } else if (header.version != MAPPED_VERSION) {
+        problem = "unsupported version";
+    } else if (header.element_size != sizeof(T) || header.element_align != alignof(T)) {
+        problem = "saved for a different element type";
+    } else if (header.count > (_length - sizeof(mapped_header)) / sizeof(T)
+               || sizeof(mapped_header) + header.count * sizeof(T) != _length) {
+        problem = "size doesn't match the header";
+    }
+    if (problem) {
+        // The destructor doesn't run when a constructor throws.
+        munmap(_mapping, _length);
+        _mapping = nullptr;
+        throw std::runtime_error(std::string(path) + ": " + problem);
+    }
+
+    _storage = (const T *) ((const char *) _mapping + sizeof(mapped_header));
+    _size = header.count;
+}
+
+template<typename T>
+mapped_vector<T>::mapped_vector(mapped_vector &&other) noexcept : mapped_vector() {
+    swap(other);
+}
+
+template<typename T>
+mapped_vector<T> &mapped_vector<T>::operator=(mapped_vector &&other) noexcept {
+    mapped_vector(std::move(other)).swap(*this);
+    return *this;
+}
+
+template<typename T>
+mapped_vector<T>::~mapped_vector() {
+    if (_mapping) munmap(_mapping, _length);
+}
+
+template<typename T>
+const T &mapped_vector<T>::operator[](std::size_t idx) const {
+    assert(idx < _size);
+    return _storage[idx];
+}
+
+template<typename T>
+const T &mapped_vector<T>::back() const {
+    assert(_size > 0);
+    return _storage[_size - 1];
+}
+
+template<typename T>
+std::size_t mapped_vector<T>::size() const {
+    return _size;
+}
+
+template<typename T>
+bool mapped_vector<T>::empty() const {
+    return _size == 0;
+}
+
+template<typename T>
+const T *mapped_vector<T>::data() const {
+    return _storage;
+}
+
+template<typename T>
+bool mapped_vector<T>::verify() const {
+    if (!_mapping) return true;
+    auto &header = *(const mapped_header *) _mapping;
+    return mapped_checksum(_storage, _size * sizeof(T)) == header.checksum;
+}
+
+template<typename T>
+typename mapped_vector<T>::const_iterator mapped_vector<T>::begin() const {
+    return _storage;
+}
+
+template<typename T>
+typename mapped_vector<T>::const_iterator mapped_vector<T>::end() const {
+    return _storage + _size;
+}
+
+template<typename T>
+typename mapped_vector<T>::const_reverse_iterator mapped_vector<T>::rbegin() const {
+    return const_reverse_iterator(end());
+}
+
+template<typename T>
+typename mapped_vector<T>::const_reverse_iterator mapped_vector<T>::rend() const {
+    return const_reverse_iterator(begin());
+}
+
+template<typename T>
+void mapped_vector<T>::swap(mapped_vector &other) noexcept {
+    std::swap(_mapping, other._mapping);
+    std::swap(_length, other._length);
+    std::swap(_storage, other._storage);
+    std::swap(_size, other._size);
+}
@@ -0,0 +1,107 @@
+#ifndef VECTOR_MAPPED_VECTOR_H
+#define VECTOR_MAPPED_VECTOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include "vector.h"
+
+// On-disk layout written by save(): this header, then the raw elements. The header is
+// 64 bytes so that elements of any alignment up to 64 start aligned in a mapped file.
+struct mapped_header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t element_size;
+    std::uint32_t element_align;
+    std::uint32_t reserved;
+    std::uint64_t count;
+    // mapped_checksum() of the element bytes.
+    std::uint64_t checksum;
+    char padding[24];
+};
+
+static_assert(sizeof(mapped_header) == 64, "mapped_header must stay 64 bytes");
+
+// FNV-1a's xor-multiply step applied to 64-bit words in the machine's byte order rather than
+// to single bytes, then to the trailing bytes one at a time. Not FNV-1a itself: it is several
+// times faster but mixes less, which is fine for catching corruption but not as a hash key.
+std::uint64_t mapped_checksum(const void *data, std::size_t bytes);
+
+// Writes `count` elements to `path`, replacing it atomically: readers that still map the old
+// file keep seeing the old contents. The data is written to a new file in the same directory and
+// synced before the rename, and the directory after it, so a crash leaves either file whole.
+// Throws std::system_error on I/O errors.
+template<typename T>
+void save(const T *data, std::size_t count, const char *path);
+
+template<typename T, typename... Policies>
+void save(const vector<T, Policies...> &v, const char *path);
+
+// Read-only view of a file written by save(). Opening maps the file and checks the header but
+// doesn't read the elements, so it takes the same time for any size; pages are loaded on first
+// access and shared with every other process mapping the same file.
+template<typename T>
+struct mapped_vector {
+    static_assert(std::is_trivially_copyable<T>::value, "only trivially copyable types can be mapped");
+    static_assert(alignof(T) <= sizeof(mapped_header), "elements would be misaligned after the header");
+
+public:
+    mapped_vector() noexcept;
+
+    // Throws std::system_error if the file can't be mapped and std::runtime_error if it wasn't
+    // written by save() for this element type.
+    explicit mapped_vector(const char *path);
+
+    mapped_vector(const mapped_vector &) = delete;
+
+    mapped_vector &operator=(const mapped_vector &) = delete;
+
+    mapped_vector(mapped_vector &&other) noexcept;
+
+    mapped_vector &operator=(mapped_vector &&other) noexcept;
+
+    ~mapped_vector();
+
+    const T &operator[](std::size_t idx) const;
+
+    const T &back() const;
+
+    std::size_t size() const;
+
+    bool empty() const;
+
+    const T *data() const;
+
+    // Reads every element and compares against the checksum in the header.
+    bool verify() const;
+
+    typedef T value_type;
+
+    typedef const T *iterator;
+    typedef const T *const_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+    typedef const_reverse_iterator reverse_iterator;
+
+    const_iterator begin() const;
+
+    const_iterator end() const;
+
+    const_reverse_iterator rbegin() const;
+
+    const_reverse_iterator rend() const;
+
+    void swap(mapped_vector &other) noexcept;
+
+    friend void swap(mapped_vector &a, mapped_vector &b) noexcept {
+        a.swap(b);
+    }
+
+private:
+    void *_mapping;
+    std::size_t _length;
+    const T *_storage;
+    std::size_t _size;
+};
+
+#endif //VECTOR_MAPPED_VECTOR_H
@@ -0,0 +1,83 @@
+#include <cassert>
+#include <cstdint>
+#include <algorithm>
+#include "memory_resource.h"
+
+monotonic_arena::monotonic_arena(std::size_t chunk_size, std::pmr::memory_resource *upstream) noexcept {
+    _upstream = upstream;
+    _next_chunk_size = std::max(chunk_size, (std::size_t) 256);
+    _reserved = 0;
+    _chunks = nullptr;
+    _cur = _end = _last = nullptr;
+}
+
+monotonic_arena::~monotonic_arena() {
+    release();
+}
+
+void monotonic_arena::release() noexcept {
+    while (_chunks) {
+        chunk *next = _chunks->next;
+        _upstream->deallocate(_chunks, _chunks->size, alignof(std::max_align_t));
+        _chunks = next;
+    }
+    _reserved = 0;
+    _cur = _end = _last = nullptr;
+}
+
+std::size_t monotonic_arena::reserved() const noexcept {
+    return _reserved;
+}
+
+void monotonic_arena::add_chunk(std::size_t min_bytes) {
+    std::size_t size = std::max(_next_chunk_size, min_bytes + sizeof(chunk));
+    auto *c = (chunk *) _upstream->allocate(size, alignof(std::max_align_t));
+    c->next = _chunks;
+    c->size = size;
+
+    _chunks = c;
+    _cur = (char *) (c + 1);
+    _end = (char *) c + size;
+    _last = nullptr;
+    _reserved += size;
+    _next_chunk_size = size * 2;
+}
+
+void *monotonic_arena::do_allocate(std::size_t bytes, std::size_t alignment) {
+    auto aligned = [&]() {
+        auto addr = (std::uintptr_t) _cur;
+        return (char *) ((addr + alignment - 1) / alignment * alignment);
+    };
+
+    char *ptr = _cur ? aligned() : nullptr;
+    if (!ptr || ptr > _end || (std::size_t) (_end - ptr) < bytes) {
+        add_chunk(bytes + alignment);
+        ptr = aligned();
+    }
+
+    _cur = ptr + bytes;
+    _last = ptr;
+    return ptr;
+}
+
+void monotonic_arena::do_deallocate(void *ptr, std::size_t bytes, std::size_t) {
+    if (ptr == _last && _last + bytes == _cur) {
+        _cur = _last;
+        _last = nullptr;
+    }
+}
+
+bool monotonic_arena::resize(void *ptr, std::size_t old_bytes, std::size_t new_bytes, std::size_t) noexcept {
+    if (ptr != _last || _last + old_bytes != _cur || (std::size_t) (_end - _last) < new_bytes) return false;
+    _cur = _last + new_bytes;
+    return true;
+}
+
+bool monotonic_arena::do_is_equal(const std::pmr::memory_resource &other) const noexcept {
+    return this == &other;
+}
+
+std::pmr::memory_resource *thread_local_pool() {
+    thread_local std::pmr::unsynchronized_pool_resource pool;
+    return &pool;
+}
@@ -0,0 +1,68 @@
+#ifndef VECTOR_MEMORY_RESOURCE_H
+#define VECTOR_MEMORY_RESOURCE_H
+
+#include <cstddef>
+#include <memory_resource>
+
+// Resource that can sometimes resize a block where it is. vector asks it before moving its
+// items to a new block.
+struct resizable_resource {
+public:
+    // Resizes the block at ptr, which holds old_bytes, to new_bytes without moving it, and
+    // returns whether it could.
+    virtual bool resize(void *ptr, std::size_t old_bytes, std::size_t new_bytes, std::size_t alignment) noexcept = 0;
+
+protected:
+    ~resizable_resource() = default;
+};
+
+// Hands out memory by bumping a pointer through chunks taken from `upstream` and frees
+// everything at once in release() or the destructor. deallocate() and resize() only work on
+// the latest allocation, which lets a single growing vector extend its block in place for as
+// long as the chunk has room.
+// Not thread-safe: meant for vectors built and dropped while serving one request.
+struct monotonic_arena : std::pmr::memory_resource, resizable_resource {
+public:
+    explicit monotonic_arena(std::size_t chunk_size = 64 * 1024,
+                             std::pmr::memory_resource *upstream = std::pmr::new_delete_resource()) noexcept;
+
+    monotonic_arena(const monotonic_arena &) = delete;
+
+    monotonic_arena &operator=(const monotonic_arena &) = delete;
+
+    ~monotonic_arena() override;
+
+    void release() noexcept;
+
+    // Bytes taken from upstream so far.
+    std::size_t reserved() const noexcept;
+
+    bool resize(void *ptr, std::size_t old_bytes, std::size_t new_bytes, std::size_t alignment) noexcept override;
+
+private:
+    struct chunk {
+        chunk *next;
+        std::size_t size;
+    };
+
+    std::pmr::memory_resource *_upstream;
+    std::size_t _next_chunk_size;
+    std::size_t _reserved;
+    chunk *_chunks;
+    char *_cur;
+    char *_end;
+    char *_last;
+
+    void add_chunk(std::size_t min_bytes);
+
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override;
+
+    void do_deallocate(void *ptr, std::size_t bytes, std::size_t alignment) override;
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+};
+
+// Pool owned by the calling thread. Memory taken from it must be released on the same thread.
+std::pmr::memory_resource *thread_local_pool();
+
+#endif //VECTOR_MEMORY_RESOURCE_H
@@ -0,0 +1,144 @@
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+#include <utility>
+#include <unistd.h>
+#include "parallel.h"
+
+namespace parallel {
+    std::size_t cache_bytes() {
+        static const std::size_t bytes = [] {
+            long l2 = -1;
+#ifdef _SC_LEVEL2_CACHE_SIZE
+            l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+#endif
+            return l2 > 0 ? (std::size_t) l2 : (std::size_t) 256 * 1024;
+        }();
+        return bytes;
+    }
+
+    std::size_t chunk_size(std::size_t n, std::size_t element_bytes, std::size_t threads) {
+        std::size_t fits_cache = std::max(cache_bytes() / 2 / element_bytes, (std::size_t) 1);
+        std::size_t balanced = (n + threads * 4 - 1) / (threads * 4);
+        std::size_t min_chunk = std::max((std::size_t) 4096 / element_bytes, (std::size_t) 1);
+        return std::max(std::min(fits_cache, balanced), min_chunk);
+    }
+
+    // Calls f(chunk index, first element, end) for consecutive chunks of `chunk` elements.
+    template<typename F>
+    void for_chunks(std::size_t n, std::size_t chunk, thread_pool &pool, F f) {
+        std::size_t chunks = (n + chunk - 1) / chunk;
+        pool.parallel_for(chunks, [&](std::size_t c) {
+            f(c, c * chunk, std::min(n, (c + 1) * chunk));
+        });
+    }
+
+    template<typename T, typename... Policies, typename F>
+    void for_each(vector<T, Policies...> &v, F f, thread_pool &pool) {
+        T *data = v.data();
+        for_chunks(v.size(), chunk_size(v.size(), sizeof(T), pool.size()), pool,
+                   [&](std::size_t, std::size_t from, std::size_t to) {
+                       std::for_each(data + from, data + to, f);
+                   });
+    }
+
+    template<typename T, typename... Policies, typename U, typename... OutPolicies, typename F>
+    void transform(const vector<T, Policies...> &in, vector<U, OutPolicies...> &out, F f, thread_pool &pool) {
+        out.resize(in.size());
+        const T *src = in.data();
+        U *dst = out.data();
+        for_chunks(in.size(), chunk_size(in.size(), sizeof(T) + sizeof(U), pool.size()), pool,
+                   [&](std::size_t, std::size_t from, std::size_t to) {
+                       std::transform(src + from, src + to, dst + from, f);
+                   });
+    }
+
+    template<typename T, typename... Policies, typename Op>
+    T reduce(const vector<T, Policies...> &v, T init, Op op, bool deterministic, thread_pool &pool) {
+        std::size_t n = v.size();
+        if (n == 0) return init;
+
+        std::size_t chunk = chunk_size(n, sizeof(T), deterministic ? 1 : pool.size());
+        std::size_t chunks = (n + chunk - 1) / chunk;
+        vector<T> partial(chunks);
+        const T *data = v.data();
+        for_chunks(n, chunk, pool, [&](std::size_t c, std::size_t from, std::size_t to) {
+            partial[c] = std::accumulate(data + from + 1, data + to, data[from], op);
+        });
+
+        for (std::size_t c = 0; c < chunks; c++) {
+            init = op(std::move(init), partial[c]);
+        }
+        return init;
+    }
+
+    // Sorts one chunk per thread with `sort_chunk`, then merges neighbouring runs pairwise in
+    // parallel rounds. The merges are stable, so the result is stable if the chunk sort is.
+    template<typename T, typename Compare, typename SortChunk>
+    void merge_sort(T *data, std::size_t n, Compare comp, thread_pool &pool, SortChunk sort_chunk) {
+        std::size_t threads = pool.size();
+        if (threads == 1 || n < 1 << 14) {
+            sort_chunk(data, data + n, comp);
+            return;
+        }
+
+        std::size_t run = (n + threads - 1) / threads;
+        for_chunks(n, run, pool, [&](std::size_t, std::size_t from, std::size_t to) {
+            sort_chunk(data + from, data + to, comp);
+        });
+
+        for (; run < n; run *= 2) {
+            std::size_t pairs = (n + 2 * run - 1) / (2 * run);
+            pool.parallel_for(pairs, [&](std::size_t p) {
+                std::size_t from = p * 2 * run;
+                std::size_t mid = std::min(n, from + run);
+                std::size_t to = std::min(n, from + 2 * run);
+                if (mid < to) std::inplace_merge(data + from, data + mid, data + to, comp);
+            });
+        }
+    }
+
+    template<typename T, typename... Policies, typename Compare>
+    void sort(vector<T, Policies...> &v, Compare comp, thread_pool &pool) {
+        merge_sort(v.data(), v.size(), comp, pool, [](T *first, T *last, Compare c) {
+            std::sort(first, last, c);
+        });
+    }
+
+    template<typename T, typename... Policies, typename Compare>
+    void stable_sort(vector<T, Policies...> &v, Compare comp, thread_pool &pool) {
+        merge_sort(v.data(), v.size(), comp, pool, [](T *first, T *last, Compare c) {
+            std::stable_sort(first, last, c);
+        });
+    }
+
+    // Two passes: fold every chunk, scan the chunk totals serially, then scan each chunk
+    // again starting from the total of everything before it.
+    template<typename T, typename... Policies, typename Op>
+    void inclusive_scan(const vector<T, Policies...> &in, vector<T, Policies...> &out, Op op, thread_pool &pool) {
+        std::size_t n = in.size();
+        out.resize(n);
+        if (n == 0) return;
+
+        std::size_t chunk = chunk_size(n, 2 * sizeof(T), pool.size());
+        std::size_t chunks = (n + chunk - 1) / chunk;
+        const T *src = in.data();
+        T *dst = out.data();
+
+        vector<T> totals(chunks);
+        for_chunks(n, chunk, pool, [&](std::size_t c, std::size_t from, std::size_t to) {
+            totals[c] = std::accumulate(src + from + 1, src + to, src[from], op);
+        });
+        for (std::size_t c = 1; c < chunks; c++) {
+            totals[c] = op(totals[c - 1], totals[c]);
+        }
+
+        for_chunks(n, chunk, pool, [&](std::size_t c, std::size_t from, std::size_t to) {
+            if (c == 0) {
+                std::inclusive_scan(src + from, src + to, dst + from, op);
+            } else {
+                std::inclusive_scan(src + from, src + to, dst + from, op, totals[c - 1]);
+            }
+        });
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef VECTOR_PARALLEL_H
+#define VECTOR_PARALLEL_H
+
+#include <cstddef>
+#include <functional>
+#include "thread_pool.h"
+#include "vector.h"
+
+// Parallel algorithms over the contiguous storage of vector. Work is split into chunks of
+// about half an L2 cache each (fewer when that would leave threads idle) and run on a
+// thread_pool, thread_pool::global() unless another one is given.
+namespace parallel {
+    std::size_t cache_bytes();
+
+    // Elements per chunk for n elements of `element_bytes` each on `threads` threads.
+    std::size_t chunk_size(std::size_t n, std::size_t element_bytes, std::size_t threads);
+
+    template<typename T, typename... Policies, typename F>
+    void for_each(vector<T, Policies...> &v, F f, thread_pool &pool = thread_pool::global());
+
+    // out[i] = f(in[i]). out is resized to in.size().
+    template<typename T, typename... Policies, typename U, typename... OutPolicies, typename F>
+    void transform(const vector<T, Policies...> &in, vector<U, OutPolicies...> &out, F f,
+                   thread_pool &pool = thread_pool::global());
+
+    // Folds the elements with an associative op. With `deterministic`, the split into chunks and
+    // the order partial results are combined in don't depend on the pool, so floating point
+    // results are identical across runs and thread counts.
+    template<typename T, typename... Policies, typename Op = std::plus<T>>
+    T reduce(const vector<T, Policies...> &v, T init, Op op = Op(), bool deterministic = false,
+             thread_pool &pool = thread_pool::global());
+
+    template<typename T, typename... Policies, typename Compare = std::less<T>>
+    void sort(vector<T, Policies...> &v, Compare comp = Compare(), thread_pool &pool = thread_pool::global());
+
+    template<typename T, typename... Policies, typename Compare = std::less<T>>
+    void stable_sort(vector<T, Policies...> &v, Compare comp = Compare(), thread_pool &pool = thread_pool::global());
+
+    // out[i] = in[0] op ... op in[i]. out is resized to in.size().
+    template<typename T, typename... Policies, typename Op = std::plus<T>>
+    void inclusive_scan(const vector<T, Policies...> &in, vector<T, Policies...> &out, Op op = Op(),
+                        thread_pool &pool = thread_pool::global());
+}
+
+#endif //VECTOR_PARALLEL_H
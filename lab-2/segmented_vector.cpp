@@ -0,0 +1,398 @@
+#include <algorithm>
+#include <cassert>
+#include <type_traits>
+#include <utility>
+#include "segmented_vector.h"
+#include "storage.h"
+
+template<typename T>
+T *segmented_vector<T>::slot(std::size_t slot) const {
+    return _chunks[slot / CHUNK] + slot % CHUNK;
+}
+
+// Pointer to the given slot, extending the chunk table and allocating the chunk if needed.
+template<typename T>
+T *segmented_vector<T>::chunk_for(std::size_t slot) {
+    std::size_t chunk = slot / CHUNK;
+    while (_chunks.size() <= chunk) {
+        _chunks.push_back(nullptr);
+    }
+    if (!_chunks[chunk]) _chunks[chunk] = smart_alloc<T>(CHUNK);
+    return _chunks[chunk] + slot % CHUNK;
+}
+
+// Makes room in the chunk table before the first chunk, doubling the table. Empty entries past
+// the last chunk go first, or a vector used as a queue from the back would keep growing it.
+template<typename T>
+void segmented_vector<T>::grow_front() {
+    while (!_chunks.empty() && !_chunks.back()) {
+        _chunks.pop_back();
+    }
+    std::size_t extra = std::max(_chunks.size(), (std::size_t) 1);
+    vector<T *> empty_chunks;
+    empty_chunks.resize(extra);
+    _chunks.insert(_chunks.begin(), empty_chunks.begin(), empty_chunks.end());
+    _start += extra * CHUNK;
+}
+
+// Drops the empty entries before the first chunk once they are more than half of the table, so
+// that a vector used as a queue keeps a table the size of its contents.
+template<typename T>
+void segmented_vector<T>::compact_front() {
+    std::size_t first = _start / CHUNK;
+    if (first > 0 && _chunks[first - 1]) first--;
+    if (first <= _chunks.size() / 2) return;
+    for (std::size_t c = 0; c < first; c++) {
+        free_chunk(c);
+    }
+    _chunks.erase(_chunks.begin(), _chunks.begin() + first);
+    _start -= first * CHUNK;
+}
+
+template<typename T>
+void segmented_vector<T>::free_chunk(std::size_t chunk) {
+    if (chunk >= _chunks.size() || !_chunks[chunk]) return;
+    smart_free(_chunks[chunk], CHUNK);
+    _chunks[chunk] = nullptr;
+}
+
+template<typename T>
+segmented_vector<T>::segmented_vector() noexcept : _start(0), _size(0) {}
+
+template<typename T>
+segmented_vector<T>::segmented_vector(std::size_t initial_size) : segmented_vector<T>() {
+    resize(initial_size);
+}
+
+template<typename T>
+segmented_vector<T>::segmented_vector(const segmented_vector<T> &other) : segmented_vector<T>() {
+    reserve(other._size);
+    for (const auto &item : other) {
+        emplace_back(item);
+    }
+}
+
+template<typename T>
+segmented_vector<T>::segmented_vector(segmented_vector<T> &&other) noexcept
+        : _chunks(std::move(other._chunks)), _start(other._start), _size(other._size) {
+    other._start = other._size = 0;
+}
+
+template<typename T>
+segmented_vector<T> &segmented_vector<T>::operator=(const segmented_vector<T> &other) {
+    segmented_vector<T> tmp(other);
+    swap(tmp);
+    return *this;
+}
+
+template<typename T>
+segmented_vector<T> &segmented_vector<T>::operator=(segmented_vector<T> &&other) noexcept {
+    segmented_vector<T> tmp(std::move(other));
+    swap(tmp);
+    return *this;
+}
+
+template<typename T>
+void segmented_vector<T>::push_back(const T &item) {
+    emplace_back(item);
+}
+
+template<typename T>
+void segmented_vector<T>::push_back(T &&item) {
+    emplace_back(std::move(item));
+}
+
+template<typename T>
+template<typename... Args>
+T &segmented_vector<T>::emplace_back(Args &&... args) {
+    T *target = chunk_for(_start + _size);
+    new(target) T(std::forward<Args>(args)...);
+    _size++;
+    return *target;
+}
+
+template<typename T>
+void segmented_vector<T>::push_front(const T &item) {
+    emplace_front(item);
+}
+
+template<typename T>
+void segmented_vector<T>::push_front(T &&item) {
+    emplace_front(std::move(item));
+}
+
+template<typename T>
+template<typename... Args>
+T &segmented_vector<T>::emplace_front(Args &&... args) {
+    if (_start == 0) grow_front();
+    T *target = chunk_for(_start - 1);
+    new(target) T(std::forward<Args>(args)...);
+    _start--;
+    _size++;
+    return *target;
+}
+
+// Popping keeps one spare chunk at each end, so a size hovering at a chunk boundary doesn't
+// allocate and free a chunk on every push/pop pair.
+template<typename T>
+void segmented_vector<T>::pop_back() {
+    assert(_size > 0);
+    std::size_t removed = _start + --_size;
+    slot(removed)->~T();
+
+    if (removed % CHUNK == 0) free_chunk(removed / CHUNK + 1);
+}
+
+template<typename T>
+void segmented_vector<T>::pop_front() {
+    assert(_size > 0);
+    std::size_t removed = _start++;
+    _size--;
+    slot(removed)->~T();
+
+    if ((removed + 1) % CHUNK == 0) {
+        if (removed >= CHUNK) free_chunk(removed / CHUNK - 1);
+        compact_front();
+    }
+}
+
+template<typename T>
+T &segmented_vector<T>::back() {
+    assert(_size > 0);
+    return *slot(_start + _size - 1);
+}
+
+template<typename T>
+const T &segmented_vector<T>::back() const {
+    assert(_size > 0);
+    return *slot(_start + _size - 1);
+}
+
+template<typename T>
+T &segmented_vector<T>::front() {
+    assert(_size > 0);
+    return *slot(_start);
+}
+
+template<typename T>
+const T &segmented_vector<T>::front() const {
+    assert(_size > 0);
+    return *slot(_start);
+}
+
+template<typename T>
+T &segmented_vector<T>::operator[](std::size_t idx) {
+    assert(idx < _size);
+    return *slot(_start + idx);
+}
+
+template<typename T>
+const T &segmented_vector<T>::operator[](std::size_t idx) const {
+    assert(idx < _size);
+    return *slot(_start + idx);
+}
+
+template<typename T>
+std::size_t segmented_vector<T>::size() const {
+    return _size;
+}
+
+template<typename T>
+bool segmented_vector<T>::empty() const {
+    return _size == 0;
+}
+
+template<typename T>
+void segmented_vector<T>::reserve(std::size_t new_capacity) {
+    if (new_capacity == 0) return;
+    for (std::size_t s = _start; s < _start + new_capacity; s += CHUNK - s % CHUNK) {
+        chunk_for(s);
+    }
+    chunk_for(_start + new_capacity - 1);
+}
+
+template<typename T>
+std::size_t segmented_vector<T>::capacity() const {
+    std::size_t chunk = _start / CHUNK;
+    std::size_t end = chunk;
+    while (end < _chunks.size() && _chunks[end]) {
+        end++;
+    }
+    return end == chunk ? 0 : end * CHUNK - _start;
+}
+
+template<typename T>
+std::size_t segmented_vector<T>::table_size() const {
+    return _chunks.size();
+}
+
+template<typename T>
+void segmented_vector<T>::shrink_to_fit() {
+    if (_size == 0) {
+        clear();
+        return;
+    }
+
+    std::size_t first = _start / CHUNK;
+    std::size_t last = (_start + _size - 1) / CHUNK;
+    for (std::size_t c = 0; c < _chunks.size(); c++) {
+        if (c < first || c > last) free_chunk(c);
+    }
+
+    vector<T *, no_shrink_growth<>> used;
+    used.reserve(last - first + 1);
+    used.append(_chunks.begin() + first, _chunks.begin() + last + 1);
+    _chunks = std::move(used);
+    _start -= first * CHUNK;
+}
+
+template<typename T>
+void segmented_vector<T>::clear() {
+    if (!std::is_trivially_destructible<T>::value) {
+        for (std::size_t s = _start; s < _start + _size; s++) {
+            slot(s)->~T();
+        }
+    }
+    for (std::size_t c = 0; c < _chunks.size(); c++) {
+        free_chunk(c);
+    }
+    _chunks.clear();
+    _start = _size = 0;
+}
+
+template<typename T>
+void segmented_vector<T>::resize(std::size_t new_size) {
+    while (_size > new_size) {
+        pop_back();
+    }
+    while (_size < new_size) {
+        emplace_back();
+    }
+}
+
+template<typename T>
+void segmented_vector<T>::resize(std::size_t new_size, const T &value) {
+    while (_size > new_size) {
+        pop_back();
+    }
+    while (_size < new_size) {
+        emplace_back(value);
+    }
+}
+
+template<typename T>
+segmented_vector<T>::~segmented_vector() {
+    clear();
+}
+
+template<typename T>
+typename segmented_vector<T>::iterator segmented_vector<T>::begin() {
+    return iterator(this, 0);
+}
+
+template<typename T>
+typename segmented_vector<T>::const_iterator segmented_vector<T>::begin() const {
+    return const_iterator(this, 0);
+}
+
+template<typename T>
+typename segmented_vector<T>::iterator segmented_vector<T>::end() {
+    return iterator(this, _size);
+}
+
+template<typename T>
+typename segmented_vector<T>::const_iterator segmented_vector<T>::end() const {
+    return const_iterator(this, _size);
+}
+
+template<typename T>
+typename segmented_vector<T>::reverse_iterator segmented_vector<T>::rbegin() {
+    return reverse_iterator(end());
+}
+
+template<typename T>
+typename segmented_vector<T>::const_reverse_iterator segmented_vector<T>::rbegin() const {
+    return const_reverse_iterator(end());
+}
+
+template<typename T>
+typename segmented_vector<T>::reverse_iterator segmented_vector<T>::rend() {
+    return reverse_iterator(begin());
+}
+
+template<typename T>
+typename segmented_vector<T>::const_reverse_iterator segmented_vector<T>::rend() const {
+    return const_reverse_iterator(begin());
+}
+
+template<typename T>
+typename segmented_vector<T>::iterator segmented_vector<T>::insert(const_iterator pos, const T &value) {
+    return emplace(pos, value);
+}
+
+template<typename T>
+typename segmented_vector<T>::iterator segmented_vector<T>::insert(const_iterator pos, T &&value) {
+    return emplace(pos, std::move(value));
+}
+
+// Elements are added at the nearer end and rotated into place; they are moved, never relocated.
+template<typename T>
+template<typename... Args>
+typename segmented_vector<T>::iterator segmented_vector<T>::emplace(const_iterator pos, Args &&... args) {
+    std::size_t idx = pos.index();
+    if (idx < _size / 2) {
+        emplace_front(std::forward<Args>(args)...);
+        std::rotate(begin(), begin() + 1, begin() + idx + 1);
+    } else {
+        emplace_back(std::forward<Args>(args)...);
+        std::rotate(begin() + idx, end() - 1, end());
+    }
+    return begin() + idx;
+}
+
+template<typename T>
+typename segmented_vector<T>::iterator segmented_vector<T>::erase(const_iterator pos) {
+    return erase(pos, pos + 1);
+}
+
+template<typename T>
+typename segmented_vector<T>::iterator segmented_vector<T>::erase(const_iterator from, const_iterator to) {
+    std::size_t from_idx = from.index();
+    std::size_t to_idx = to.index();
+    std::size_t diff = to_idx - from_idx;
+
+    if (from_idx < _size - to_idx) {
+        std::move_backward(begin(), begin() + from_idx, begin() + to_idx);
+        for (std::size_t i = 0; i < diff; i++) {
+            pop_front();
+        }
+    } else {
+        std::move(begin() + to_idx, end(), begin() + from_idx);
+        for (std::size_t i = 0; i < diff; i++) {
+            pop_back();
+        }
+    }
+    return begin() + from_idx;
+}
+
+template<typename T>
+template<typename Iterator>
+segmented_vector<T>::segmented_vector(Iterator first, Iterator last) : segmented_vector<T>() {
+    assign(first, last);
+}
+
+template<typename T>
+template<typename Iterator>
+void segmented_vector<T>::assign(Iterator first, Iterator last) {
+    clear();
+    for (; first != last; ++first) {
+        emplace_back(*first);
+    }
+}
+
+template<typename T>
+void segmented_vector<T>::swap(segmented_vector<T> &other) noexcept {
+    _chunks.swap(other._chunks);
+    std::swap(_start, other._start);
+    std::swap(_size, other._size);
+}
@@ -0,0 +1,206 @@
+#ifndef VECTOR_SEGMENTED_VECTOR_H
+#define VECTOR_SEGMENTED_VECTOR_H
+
+#include <cstddef>
+#include <iterator>
+#include "vector.h"
+
+// vector made of fixed-size chunks reached through a chunk table. Growing at either end adds
+// a chunk at most, so elements are never relocated and references to them stay valid until
+// the element is removed. The table itself is a vector of pointers and only ever copies those.
+// Unlike vector, the elements are not contiguous, so there is no data().
+template<typename T>
+struct segmented_vector {
+public:
+    static constexpr std::size_t CHUNK = sizeof(T) < 256 ? 4096 / sizeof(T) : 16;
+
+    segmented_vector() noexcept;
+
+    explicit segmented_vector(std::size_t initial_size);
+
+    segmented_vector(const segmented_vector<T> &other);
+
+    segmented_vector(segmented_vector<T> &&other) noexcept;
+
+    segmented_vector &operator=(const segmented_vector<T> &other);
+
+    segmented_vector &operator=(segmented_vector<T> &&other) noexcept;
+
+    void push_back(const T &item);
+
+    void push_back(T &&item);
+
+    template<typename... Args>
+    T &emplace_back(Args &&... args);
+
+    void push_front(const T &item);
+
+    void push_front(T &&item);
+
+    template<typename... Args>
+    T &emplace_front(Args &&... args);
+
+    void pop_back();
+
+    void pop_front();
+
+    T &back();
+
+    const T &back() const;
+
+    T &front();
+
+    const T &front() const;
+
+    T &operator[](std::size_t idx);
+
+    const T &operator[](std::size_t idx) const;
+
+    std::size_t size() const;
+
+    bool empty() const;
+
+    // Allocates chunks so that the back can grow to new_capacity elements without allocating.
+    void reserve(std::size_t new_capacity);
+
+    std::size_t capacity() const;
+
+    // Entries in the chunk table, including the empty ones on either side of the elements.
+    std::size_t table_size() const;
+
+    void shrink_to_fit();
+
+    void clear();
+
+    void resize(std::size_t new_size);
+
+    void resize(std::size_t new_size, const T &value);
+
+    ~segmented_vector();
+
+    // Iterators:
+
+    template<bool Const>
+    struct basic_iterator {
+        typedef std::random_access_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef typename std::conditional<Const, const T *, T *>::type pointer;
+        typedef typename std::conditional<Const, const T &, T &>::type reference;
+        typedef typename std::conditional<Const, const segmented_vector, segmented_vector>::type owner;
+
+        basic_iterator() : _owner(nullptr), _idx(0) {}
+
+        basic_iterator(owner *o, std::size_t idx) : _owner(o), _idx(idx) {}
+
+        operator basic_iterator<true>() const { return basic_iterator<true>(_owner, _idx); }
+
+        reference operator*() const { return (*_owner)[_idx]; }
+
+        pointer operator->() const { return &(*_owner)[_idx]; }
+
+        reference operator[](difference_type n) const { return (*_owner)[_idx + n]; }
+
+        basic_iterator &operator++() { ++_idx; return *this; }
+
+        basic_iterator operator++(int) { basic_iterator old = *this; ++_idx; return old; }
+
+        basic_iterator &operator--() { --_idx; return *this; }
+
+        basic_iterator operator--(int) { basic_iterator old = *this; --_idx; return old; }
+
+        basic_iterator &operator+=(difference_type n) { _idx += n; return *this; }
+
+        basic_iterator &operator-=(difference_type n) { _idx -= n; return *this; }
+
+        basic_iterator operator+(difference_type n) const { return basic_iterator(_owner, _idx + n); }
+
+        basic_iterator operator-(difference_type n) const { return basic_iterator(_owner, _idx - n); }
+
+        friend basic_iterator operator+(difference_type n, const basic_iterator &it) { return it + n; }
+
+        difference_type operator-(const basic_iterator &other) const {
+            return (difference_type) _idx - (difference_type) other._idx;
+        }
+
+        bool operator==(const basic_iterator &other) const { return _idx == other._idx; }
+
+        bool operator!=(const basic_iterator &other) const { return _idx != other._idx; }
+
+        bool operator<(const basic_iterator &other) const { return _idx < other._idx; }
+
+        bool operator>(const basic_iterator &other) const { return _idx > other._idx; }
+
+        bool operator<=(const basic_iterator &other) const { return _idx <= other._idx; }
+
+        bool operator>=(const basic_iterator &other) const { return _idx >= other._idx; }
+
+        std::size_t index() const { return _idx; }
+
+    private:
+        owner *_owner;
+        std::size_t _idx;
+    };
+
+    typedef basic_iterator<false> iterator;
+    typedef basic_iterator<true> const_iterator;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    iterator begin();
+
+    const_iterator begin() const;
+
+    iterator end();
+
+    const_iterator end() const;
+
+    reverse_iterator rbegin();
+
+    const_reverse_iterator rbegin() const;
+
+    reverse_iterator rend();
+
+    const_reverse_iterator rend() const;
+
+    iterator insert(const_iterator pos, const T &value);
+
+    iterator insert(const_iterator pos, T &&value);
+
+    template<typename... Args>
+    iterator emplace(const_iterator pos, Args &&... args);
+
+    iterator erase(const_iterator pos);
+
+    iterator erase(const_iterator from, const_iterator to);
+
+    template<typename Iterator>
+    segmented_vector(Iterator first, Iterator last);
+
+    template<typename Iterator>
+    void assign(Iterator first, Iterator last);
+
+    void swap(segmented_vector<T> &other) noexcept;
+
+    friend void swap(segmented_vector<T> &a, segmented_vector<T> &b) noexcept {
+        a.swap(b);
+    }
+
+private:
+    // Element i lives in slot _start + i of the chunks laid end to end.
+    vector<T *, no_shrink_growth<>> _chunks;
+    std::size_t _start;
+    std::size_t _size;
+
+    T *slot(std::size_t slot) const;
+
+    T *chunk_for(std::size_t slot);
+
+    void grow_front();
+
+    void compact_front();
+
+    void free_chunk(std::size_t chunk);
+};
+
+#endif //VECTOR_SEGMENTED_VECTOR_H
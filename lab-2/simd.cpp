@@ -0,0 +1,158 @@
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include "simd.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_X86 1
+#endif
+
+#ifdef SIMD_X86
+#pragma GCC push_options
+#pragma GCC target("sse2")
+namespace simd { namespace sse2 {
+    const std::size_t REG_BYTES = 16;
+#include "simd_kernels.h"
+}}
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+namespace simd { namespace avx2 {
+    const std::size_t REG_BYTES = 32;
+#include "simd_kernels.h"
+}}
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+namespace simd { namespace avx512 {
+    const std::size_t REG_BYTES = 64;
+#include "simd_kernels.h"
+}}
+#pragma GCC pop_options
+#endif
+
+namespace simd {
+    isa detected_isa() {
+        static const isa level = [] {
+#ifdef SIMD_X86
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512f")) return isa::avx512;
+            if (__builtin_cpu_supports("avx2")) return isa::avx2;
+            return isa::sse2;
+#else
+            return isa::scalar;
+#endif
+        }();
+        return level;
+    }
+
+    isa &current_isa() {
+        static isa level = detected_isa();
+        return level;
+    }
+
+    isa active_isa() {
+        return current_isa();
+    }
+
+    void use_isa(isa level) {
+        current_isa() = std::min(level, detected_isa());
+    }
+
+    // Calls `vectorized` with the kernels for the active instruction set, or `scalar` if T has none.
+    template<typename T, typename Vectorized, typename Scalar>
+    auto dispatch(Vectorized vectorized, Scalar scalar) -> decltype(scalar()) {
+#ifdef SIMD_X86
+        if constexpr (is_simd_type<T>::value) {
+            switch (active_isa()) {
+                case isa::avx512:
+                    return vectorized(avx512::kernels<T>());
+                case isa::avx2:
+                    return vectorized(avx2::kernels<T>());
+                case isa::sse2:
+                    return vectorized(sse2::kernels<T>());
+                case isa::scalar:
+                    break;
+            }
+        }
+#endif
+        return scalar();
+    }
+
+    template<typename T>
+    std::size_t find(const T *data, std::size_t n, T value) {
+        return dispatch<T>([&](auto k) { return decltype(k)::find(data, n, value); },
+                           [&] { return (std::size_t) (std::find(data, data + n, value) - data); });
+    }
+
+    template<typename T>
+    std::size_t count(const T *data, std::size_t n, T value) {
+        return dispatch<T>([&](auto k) { return decltype(k)::count(data, n, value); },
+                           [&] { return (std::size_t) std::count(data, data + n, value); });
+    }
+
+    template<typename T>
+    std::size_t min_element(const T *data, std::size_t n) {
+        if (n == 0) return 0;
+        return dispatch<T>([&](auto k) { return decltype(k)::min_element(data, n); },
+                           [&] { return (std::size_t) (std::min_element(data, data + n) - data); });
+    }
+
+    template<typename T>
+    std::size_t max_element(const T *data, std::size_t n) {
+        if (n == 0) return 0;
+        return dispatch<T>([&](auto k) { return decltype(k)::max_element(data, n); },
+                           [&] { return (std::size_t) (std::max_element(data, data + n) - data); });
+    }
+
+    template<typename T>
+    T sum(const T *data, std::size_t n) {
+        return dispatch<T>([&](auto k) { return decltype(k)::sum(data, n); },
+                           [&] { return std::accumulate(data, data + n, T()); });
+    }
+
+    template<typename T>
+    T dot(const T *a, const T *b, std::size_t n) {
+        return dispatch<T>([&](auto k) { return decltype(k)::dot(a, b, n); },
+                           [&] { return std::inner_product(a, a + n, b, T()); });
+    }
+
+    template<typename T>
+    void transform_scalar(const T *a, const T *b, T *out, std::size_t n, op o) {
+        switch (o) {
+            case op::add:
+                std::transform(a, a + n, b, out, std::plus<T>());
+                break;
+            case op::sub:
+                std::transform(a, a + n, b, out, std::minus<T>());
+                break;
+            case op::mul:
+                std::transform(a, a + n, b, out, std::multiplies<T>());
+                break;
+            case op::min:
+                std::transform(a, a + n, b, out, [](const T &x, const T &y) { return std::min(x, y); });
+                break;
+            case op::max:
+                std::transform(a, a + n, b, out, [](const T &x, const T &y) { return std::max(x, y); });
+                break;
+        }
+    }
+
+    template<typename T>
+    void transform(const T *a, const T *b, T *out, std::size_t n, op o) {
+        dispatch<T>([&](auto k) { decltype(k)::transform(a, b, out, n, o); },
+                    [&] { transform_scalar(a, b, out, n, o); });
+    }
+
+    template<typename T, typename... Policies>
+    void transform(const vector<T, Policies...> &a, const vector<T, Policies...> &b, vector<T, Policies...> &out, op o) {
+        assert(a.size() == b.size());
+        if (&out != &a && &out != &b) out.resize(a.size());
+        transform(a.data(), b.data(), out.data(), a.size(), o);
+    }
+}
@@ -0,0 +1,94 @@
+#ifndef VECTOR_SIMD_H
+#define VECTOR_SIMD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include "vector.h"
+
+// Vectorized scans over contiguous int32_t, float and double data, dispatched at runtime
+// to AVX-512, AVX2 or SSE2. Other element types run the equivalent std:: algorithm.
+// Reductions over floating point values add in a different order than std::accumulate,
+// so results may differ in the last bits. NaNs are not supported by min/max_element.
+namespace simd {
+    enum struct op {
+        add, sub, mul, min, max
+    };
+
+    enum struct isa {
+        scalar, sse2, avx2, avx512
+    };
+
+    // Best instruction set the CPU supports.
+    isa detected_isa();
+
+    // Instruction set the kernels currently run on: detected_isa() unless lowered with use_isa().
+    isa active_isa();
+
+    // Runs the kernels on `level`, or on detected_isa() if the CPU doesn't support `level`.
+    void use_isa(isa level);
+
+    template<typename T>
+    struct is_simd_type : std::integral_constant<bool,
+            std::is_same<T, std::int32_t>::value || std::is_same<T, float>::value || std::is_same<T, double>::value> {
+    };
+
+    // Index of the first element equal to value, or n.
+    template<typename T>
+    std::size_t find(const T *data, std::size_t n, T value);
+
+    template<typename T>
+    std::size_t count(const T *data, std::size_t n, T value);
+
+    // Index of the first smallest (largest) element, or n for an empty range.
+    template<typename T>
+    std::size_t min_element(const T *data, std::size_t n);
+
+    template<typename T>
+    std::size_t max_element(const T *data, std::size_t n);
+
+    template<typename T>
+    T sum(const T *data, std::size_t n);
+
+    template<typename T>
+    T dot(const T *a, const T *b, std::size_t n);
+
+    // out[i] = a[i] o b[i]. out may be the same array as a or b.
+    template<typename T>
+    void transform(const T *a, const T *b, T *out, std::size_t n, op o);
+
+    template<typename T, typename... Policies>
+    std::size_t find(const vector<T, Policies...> &v, typename vector<T, Policies...>::value_type value) {
+        return find(v.data(), v.size(), value);
+    }
+
+    template<typename T, typename... Policies>
+    std::size_t count(const vector<T, Policies...> &v, typename vector<T, Policies...>::value_type value) {
+        return count(v.data(), v.size(), value);
+    }
+
+    template<typename T, typename... Policies>
+    std::size_t min_element(const vector<T, Policies...> &v) {
+        return min_element(v.data(), v.size());
+    }
+
+    template<typename T, typename... Policies>
+    std::size_t max_element(const vector<T, Policies...> &v) {
+        return max_element(v.data(), v.size());
+    }
+
+    template<typename T, typename... Policies>
+    T sum(const vector<T, Policies...> &v) {
+        return sum(v.data(), v.size());
+    }
+
+    template<typename T, typename... Policies>
+    T dot(const vector<T, Policies...> &a, const vector<T, Policies...> &b) {
+        return dot(a.data(), b.data(), a.size() < b.size() ? a.size() : b.size());
+    }
+
+    template<typename T, typename... Policies>
+    void transform(const vector<T, Policies...> &a, const vector<T, Policies...> &b, vector<T, Policies...> &out, op o);
+}
+
+#endif //VECTOR_SIMD_H
@@ -0,0 +1,174 @@
+// Generic kernels over REG_BYTES-wide registers, written with GCC vector extensions.
+// Deliberately has no include guard: simd.cpp includes it once per instruction set,
+// inside a namespace that defines REG_BYTES and under the matching `#pragma GCC target`.
+
+template<typename T>
+struct kernels {
+    typedef T reg __attribute__((vector_size(REG_BYTES)));
+    typedef decltype(reg{} == reg{}) mask;
+
+    static const std::size_t width = REG_BYTES / sizeof(T);
+
+    static reg load(const T *ptr) {
+        reg result;
+        __builtin_memcpy(&result, ptr, sizeof(result));
+        return result;
+    }
+
+    static void store(T *ptr, reg value) {
+        __builtin_memcpy(ptr, &value, sizeof(value));
+    }
+
+    static reg broadcast(T value) {
+        return reg{} + value;
+    }
+
+    static bool any(mask m) {
+        unsigned long long parts[REG_BYTES / sizeof(unsigned long long)];
+        __builtin_memcpy(parts, &m, sizeof(m));
+        unsigned long long result = 0;
+        for (auto part : parts) {
+            result |= part;
+        }
+        return result != 0;
+    }
+
+    static std::size_t find(const T *data, std::size_t n, T value) {
+        const reg needle = broadcast(value);
+        std::size_t i = 0;
+        for (; i + width <= n; i += width) {
+            if (any(load(data + i) == needle)) break;
+        }
+        for (; i < n; i++) {
+            if (data[i] == value) return i;
+        }
+        return n;
+    }
+
+    static std::size_t count(const T *data, std::size_t n, T value) {
+        // Lane counters are as wide as T, so flush them before they can overflow.
+        const std::size_t flush_every = width << 20;
+        const reg needle = broadcast(value);
+        std::size_t result = 0;
+        std::size_t i = 0;
+        while (i + width <= n) {
+            mask acc = {};
+            std::size_t stop = std::min(n - n % width, i + flush_every);
+            for (; i < stop; i += width) {
+                acc -= load(data + i) == needle;
+            }
+            for (std::size_t j = 0; j < width; j++) {
+                result += (std::size_t) acc[j];
+            }
+        }
+        for (; i < n; i++) {
+            if (data[i] == value) result++;
+        }
+        return result;
+    }
+
+    template<typename Less>
+    static std::size_t extremum(const T *data, std::size_t n, Less less) {
+        if (n == 0) return 0;
+
+        T best = data[0];
+        std::size_t i = 0;
+        if (n >= width) {
+            reg acc = load(data);
+            for (i = width; i + width <= n; i += width) {
+                reg cur = load(data + i);
+                acc = less(cur, acc) ? cur : acc;
+            }
+            for (std::size_t j = 0; j < width; j++) {
+                if (less(acc[j], best)) best = acc[j];
+            }
+        }
+        for (; i < n; i++) {
+            if (less(data[i], best)) best = data[i];
+        }
+        return find(data, n, best);
+    }
+
+    static std::size_t min_element(const T *data, std::size_t n) {
+        return extremum(data, n, [](auto a, auto b) { return a < b; });
+    }
+
+    static std::size_t max_element(const T *data, std::size_t n) {
+        return extremum(data, n, [](auto a, auto b) { return a > b; });
+    }
+
+    static T sum(const T *data, std::size_t n) {
+        reg acc0 = {}, acc1 = {}, acc2 = {}, acc3 = {};
+        std::size_t i = 0;
+        for (; i + 4 * width <= n; i += 4 * width) {
+            acc0 += load(data + i);
+            acc1 += load(data + i + width);
+            acc2 += load(data + i + 2 * width);
+            acc3 += load(data + i + 3 * width);
+        }
+        for (; i + width <= n; i += width) {
+            acc0 += load(data + i);
+        }
+        reg acc = (acc0 + acc1) + (acc2 + acc3);
+        T result = 0;
+        for (std::size_t j = 0; j < width; j++) {
+            result += acc[j];
+        }
+        for (; i < n; i++) {
+            result += data[i];
+        }
+        return result;
+    }
+
+    static T dot(const T *a, const T *b, std::size_t n) {
+        reg acc0 = {}, acc1 = {};
+        std::size_t i = 0;
+        for (; i + 2 * width <= n; i += 2 * width) {
+            acc0 += load(a + i) * load(b + i);
+            acc1 += load(a + i + width) * load(b + i + width);
+        }
+        for (; i + width <= n; i += width) {
+            acc0 += load(a + i) * load(b + i);
+        }
+        reg acc = acc0 + acc1;
+        T result = 0;
+        for (std::size_t j = 0; j < width; j++) {
+            result += acc[j];
+        }
+        for (; i < n; i++) {
+            result += a[i] * b[i];
+        }
+        return result;
+    }
+
+    template<typename F>
+    static void apply(const T *a, const T *b, T *out, std::size_t n, F f) {
+        std::size_t i = 0;
+        for (; i + width <= n; i += width) {
+            store(out + i, f(load(a + i), load(b + i)));
+        }
+        for (; i < n; i++) {
+            out[i] = f(a[i], b[i]);
+        }
+    }
+
+    static void transform(const T *a, const T *b, T *out, std::size_t n, simd::op o) {
+        switch (o) {
+            case simd::op::add:
+                apply(a, b, out, n, [](auto x, auto y) { return x + y; });
+                break;
+            case simd::op::sub:
+                apply(a, b, out, n, [](auto x, auto y) { return x - y; });
+                break;
+            case simd::op::mul:
+                apply(a, b, out, n, [](auto x, auto y) { return x * y; });
+                break;
+            case simd::op::min:
+                apply(a, b, out, n, [](auto x, auto y) { return y < x ? y : x; });
+                break;
+            case simd::op::max:
+                apply(a, b, out, n, [](auto x, auto y) { return x < y ? y : x; });
+                break;
+        }
+    }
+};
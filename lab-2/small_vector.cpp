@@ -0,0 +1,450 @@
+#include <cassert>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <algorithm>
+#include "small_vector.h"
+#include "storage.h"
+
+template<typename T, std::size_t N, typename Growth>
+T *small_vector<T, N, Growth>::inline_storage() {
+    return reinterpret_cast<T *>(_inline);
+}
+
+template<typename T, std::size_t N, typename Growth>
+bool small_vector<T, N, Growth>::is_inline() const {
+    return _storage == reinterpret_cast<const T *>(_inline);
+}
+
+template<typename T, std::size_t N, typename Growth>
+small_vector<T, N, Growth>::small_vector() noexcept {
+    _size = 0;
+    _capacity = N;
+    _storage = inline_storage();
+}
+
+template<typename T, std::size_t N, typename Growth>
+small_vector<T, N, Growth>::small_vector(std::size_t initial_size) : small_vector() {
+    reserve(initial_size);
+    try {
+        for (; _size < initial_size; _size++) {
+            new(&_storage[_size]) T();
+        }
+    } catch (...) {
+        clear();
+        throw;
+    }
+}
+
+template<typename T, std::size_t N, typename Growth>
+small_vector<T, N, Growth>::small_vector(const small_vector &other) : small_vector() {
+    reserve(other._size);
+    try {
+        smart_copy(other._storage, _storage, other._size);
+    } catch (...) {
+        clear();
+        throw;
+    }
+    _size = other._size;
+}
+
+template<typename T, std::size_t N, typename Growth>
+small_vector<T, N, Growth>::small_vector(small_vector &&other) noexcept(std::is_nothrow_move_constructible<T>::value)
+        : small_vector() {
+    steal(other);
+}
+
+// Takes over the elements of `other`, leaving it empty and inline. *this must be empty and inline.
+template<typename T, std::size_t N, typename Growth>
+void small_vector<T, N, Growth>::steal(small_vector &other) {
+    assert(_size == 0 && is_inline());
+
+    if (other.is_inline()) {
+        smart_move(other._storage, _storage, other._size);
+        smart_destroy(other._storage, other._size);
+    } else {
+        _storage = other._storage;
+        _capacity = other._capacity;
+        other._storage = other.inline_storage();
+        other._capacity = N;
+    }
+    _size = other._size;
+    other._size = 0;
+}
+
+template<typename T, std::size_t N, typename Growth>
+small_vector<T, N, Growth> &small_vector<T, N, Growth>::operator=(const small_vector &other) {
+    if (this != &other) {
+        small_vector tmp(other);
+        clear();
+        steal(tmp);
+    }
+    return *this;
+}
+
+template<typename T, std::size_t N, typename Growth>
+small_vector<T, N, Growth> &small_vector<T, N, Growth>::operator=(small_vector &&other)
+        noexcept(std::is_nothrow_move_constructible<T>::value) {
+    if (this != &other) {
+        clear();
+        steal(other);
+    }
+    return *this;
+}
+
+// Moves the elements into a buffer of `new_capacity`, or back into the object when they fit there.
+template<typename T, std::size_t N, typename Growth>
+void small_vector<T, N, Growth>::relocate(std::size_t new_capacity) {
+    assert(new_capacity >= _size);
+
+    if (new_capacity <= N) {
+        if (is_inline()) return;
+
+        smart_move(_storage, inline_storage(), _size);
+        smart_delete(_storage, _size, _capacity);
+        _storage = inline_storage();
+        _capacity = N;
+    } else if (is_inline()) {
+        T *heap = smart_alloc<T>(new_capacity);
+        try {
+            smart_move(_storage, heap, _size);
+        } catch (...) {
+            smart_free(heap, new_capacity);
+            throw;
+        }
+        smart_destroy(_storage, _size);
+        _storage = heap;
+        _capacity = new_capacity;
+    } else {
+        _storage = smart_relocate(_storage, _size, _capacity, new_capacity);
+        _capacity = new_capacity;
+    }
+}
+
+template<typename T, std::size_t N, typename Growth>
+void small_vector<T, N, Growth>::increase_capacity() {
+    assert(_size == _capacity);
+    relocate(Growth::grow(_capacity));
+}
+
+template<typename T, std::size_t N, typename Growth>
+void small_vector<T, N, Growth>::push_back(const T &item) {
+    emplace_back(item);
+}
+
+template<typename T, std::size_t N, typename Growth>
+void small_vector<T, N, Growth>::push_back(T &&item) {
+    emplace_back(std::move(item));
+}
+
+template<typename T, std::size_t N, typename Growth>
+template<typename... Args>
+T &small_vector<T, N, Growth>::emplace_back(Args &&... args) {
+    if (_size == _capacity) {
+        T item(std::forward<Args>(args)...);
+        increase_capacity();
+        new(&_storage[_size]) T(std::move(item));
+    } else {
+        new(&_storage[_size]) T(std::forward<Args>(args)...);
+    }
+    return _storage[_size++];
+}
+
+template<typename T, std::size_t N, typename Growth>
+void small_vector<T, N, Growth>::pop_back() {
+    assert(_size > 0);
+    _storage[--_size].~T();
+
+    if (!is_inline() && Growth::should_shrink(_size, _capacity)) {
+        relocate(Growth::shrink(_capacity));
+    }
+}
+
+template<typename T, std::size_t N, typename Growth>
+std::size_t small_vector<T, N, Growth>::size() const {
+    return _size;
+}
+
+template<typename T, std::size_t N, typename Growth>
+bool small_vector<T, N, Growth>::empty() const {
+    return _size == 0;
+}
+
+template<typename T, std::size_t N, typename Growth>
+std::size_t small_vector<T, N, Growth>::capacity() const {
+    return _capacity;
+}
+
+template<typename T, std::size_t N, typename Growth>
+void small_vector<T, N, Growth>::reserve(std::size_t new_capacity) {
+    if (new_capacity <= _capacity) return;
+
+    relocate(new_capacity);
+}
+
+template<typename T, std::size_t N, typename Growth>
+void small_vector<T, N, Growth>::shrink_to_fit() {
+    if (is_inline() || _size == _capacity) return;
+
+    relocate(_size);
+}
+
+template<typename T, std::size_t N, typename Growth>
+T *small_vector<T, N, Growth>::data() {
+    return _storage;
+}
+
+template<typename T, std::size_t N, typename Growth>
+const T *small_vector<T, N, Growth>::data() const {
+    return _storage;
+}
+
+template<typename T, std::size_t N, typename Growth>
+T &small_vector<T, N, Growth>::back() {
+    assert(_size > 0);
+    return _storage[_size - 1];
+}
+
+template<typename T, std::size_t N, typename Growth>
+const T &small_vector<T, N, Growth>::back() const {
+    assert(_size > 0);
+    return _storage[_size - 1];
+}
+
+template<typename T, std::size_t N, typename Growth>
+T &small_vector<T, N, Growth>::operator[](std::size_t idx) {
+    assert(idx < _size);
+    return _storage[idx];
+}
+
+template<typename T, std::size_t N, typename Growth>
+const T &small_vector<T, N, Growth>::operator[](std::size_t idx) const {
+    assert(idx < _size);
+    return _storage[idx];
+}
+
+template<typename T, std::size_t N, typename Growth>
+void small_vector<T, N, Growth>::resize(std::size_t new_size, T value) {
+    if (new_size < _size) {
+        smart_destroy(_storage + new_size, _size - new_size);
+        _size = new_size;
+        return;
+    }
+
+    reserve(new_size);
+
+    for (; _size < new_size; _size++) {
+        new(&_storage[_size]) T(value);
+    }
+}
+
+template<typename T, std::size_t N, typename Growth>
+void small_vector<T, N, Growth>::clear() {
+    if (is_inline()) {
+        smart_destroy(_storage, _size);
+    } else {
+        smart_delete(_storage, _size, _capacity);
+        _storage = inline_storage();
+        _capacity = N;
+    }
+    _size = 0;
+}
+
+template<typename T, std::size_t N, typename Growth>
+typename small_vector<T, N, Growth>::iterator small_vector<T, N, Growth>::begin() {
+    return _storage;
+}
+
+template<typename T, std::size_t N, typename Growth>
+typename small_vector<T, N, Growth>::iterator small_vector<T, N, Growth>::end() {
+    return _storage + _size;
+}
+
+template<typename T, std::size_t N, typename Growth>
+typename small_vector<T, N, Growth>::const_iterator small_vector<T, N, Growth>::begin() const {
+    return _storage;
+}
+
+template<typename T, std::size_t N, typename Growth>
+typename small_vector<T, N, Growth>::const_iterator small_vector<T, N, Growth>::end() const {
+    return _storage + _size;
+}
+
+template<typename T, std::size_t N, typename Growth>
+typename small_vector<T, N, Growth>::reverse_iterator small_vector<T, N, Growth>::rbegin() {
+    return reverse_iterator(end());
+}
+
+template<typename T, std::size_t N, typename Growth>
+typename small_vector<T, N, Growth>::reverse_iterator small_vector<T, N, Growth>::rend() {
+    return reverse_iterator(begin());
+}
+
+template<typename T, std::size_t N, typename Growth>
+typename small_vector<T, N, Growth>::const_reverse_iterator small_vector<T, N, Growth>::rbegin() const {
+    return const_reverse_iterator(end());
+}
+
+template<typename T, std::size_t N, typename Growth>
+typename small_vector<T, N, Growth>::const_reverse_iterator small_vector<T, N, Growth>::rend() const {
+    return const_reverse_iterator(begin());
+}
+
+template<typename T, std::size_t N, typename Growth>
+template<typename Iterator>
+small_vector<T, N, Growth>::small_vector(Iterator first, Iterator last) : small_vector() {
+    try {
+        append(first, last);
+    } catch (...) {
+        clear();
+        throw;
+    }
+}
+
+template<typename T, std::size_t N, typename Growth>
+template<typename Iterator>
+void small_vector<T, N, Growth>::assign(Iterator first, Iterator last) {
+    smart_destroy(_storage, _size);
+    _size = 0;
+    append(first, last);
+}
+
+template<typename T, std::size_t N, typename Growth>
+template<typename Iterator>
+typename small_vector<T, N, Growth>::iterator small_vector<T, N, Growth>::insert(const_iterator pos, Iterator first,
+                                                                                 Iterator last) {
+    std::size_t idx = pos - begin();
+    insert_range(idx, first, last, typename std::iterator_traits<Iterator>::iterator_category());
+    return begin() + idx;
+}
+
+template<typename T, std::size_t N, typename Growth>
+template<typename Iterator>
+void small_vector<T, N, Growth>::append(Iterator first, Iterator last) {
+    insert_range(_size, first, last, typename std::iterator_traits<Iterator>::iterator_category());
+}
+
+template<typename T, std::size_t N, typename Growth>
+template<typename Iterator>
+void small_vector<T, N, Growth>::insert_range(std::size_t idx, Iterator first, Iterator last,
+                                              std::forward_iterator_tag) {
+    insert_n(idx, first, (std::size_t) std::distance(first, last));
+}
+
+template<typename T, std::size_t N, typename Growth>
+template<typename Iterator>
+void small_vector<T, N, Growth>::insert_range(std::size_t idx, Iterator first, Iterator last,
+                                              std::input_iterator_tag) {
+    std::size_t old_size = _size;
+    for (; first != last; ++first) {
+        emplace_back(*first);
+    }
+    std::rotate(_storage + idx, _storage + old_size, _storage + _size);
+}
+
+template<typename T, std::size_t N, typename Growth>
+template<typename Iterator>
+void small_vector<T, N, Growth>::insert_n(std::size_t idx, Iterator first, std::size_t cnt) {
+    assert(idx <= _size);
+    if (cnt == 0) return;
+
+    if (_size + cnt <= _capacity) {
+        smart_insert_n(_storage, _size, idx, first, cnt);
+        _size += cnt;
+        return;
+    }
+
+    // Past the inline capacity, so the result always goes to the heap.
+    std::size_t new_capacity = std::max(Growth::grow(_capacity), _size + cnt);
+    T *heap = smart_alloc<T>(new_capacity);
+    try {
+        smart_insert_into(_storage, _size, idx, first, cnt, heap);
+    } catch (...) {
+        smart_free(heap, new_capacity);
+        throw;
+    }
+    if (is_inline()) {
+        smart_destroy(_storage, _size);
+    } else {
+        smart_delete(_storage, _size, _capacity);
+    }
+    _storage = heap;
+    _capacity = new_capacity;
+    _size += cnt;
+}
+
+template<typename T, std::size_t N, typename Growth>
+template<typename Predicate>
+std::size_t small_vector<T, N, Growth>::erase_if(Predicate pred) {
+    std::size_t old_size = _size;
+    _size = smart_erase_if(_storage, _size, pred);
+    return old_size - _size;
+}
+
+template<typename T, std::size_t N, typename Growth>
+typename small_vector<T, N, Growth>::iterator small_vector<T, N, Growth>::swap_erase(const_iterator pos) {
+    std::size_t idx = pos - begin();
+    assert(idx < _size);
+    _size = smart_swap_erase(_storage, _size, idx);
+    return begin() + idx;
+}
+
+template<typename T, std::size_t N, typename Growth>
+typename small_vector<T, N, Growth>::iterator small_vector<T, N, Growth>::insert(const_iterator pos, const T &value) {
+    return emplace(pos, value);
+}
+
+template<typename T, std::size_t N, typename Growth>
+typename small_vector<T, N, Growth>::iterator small_vector<T, N, Growth>::insert(const_iterator pos, T &&value) {
+    return emplace(pos, std::move(value));
+}
+
+template<typename T, std::size_t N, typename Growth>
+template<typename... Args>
+typename small_vector<T, N, Growth>::iterator small_vector<T, N, Growth>::emplace(const_iterator pos, Args &&... args) {
+    std::size_t idx = pos - begin();
+    if (idx == _size) {
+        emplace_back(std::forward<Args>(args)...);
+        return begin() + idx;
+    }
+
+    T item(std::forward<Args>(args)...);
+    if (_size == _capacity) increase_capacity();
+    smart_emplace_at(_storage, _size, idx, item);
+
+    return begin() + idx;
+}
+
+template<typename T, std::size_t N, typename Growth>
+typename small_vector<T, N, Growth>::iterator small_vector<T, N, Growth>::erase(const_iterator pos) {
+    return erase(pos, pos + 1);
+}
+
+template<typename T, std::size_t N, typename Growth>
+typename small_vector<T, N, Growth>::iterator small_vector<T, N, Growth>::erase(const_iterator from, const_iterator to) {
+    std::size_t from_idx = from - begin();
+    std::size_t to_idx = to - begin();
+
+    _size = smart_erase(_storage, _size, from_idx, to_idx);
+
+    return begin() + from_idx;
+}
+
+template<typename T, std::size_t N, typename Growth>
+void small_vector<T, N, Growth>::swap(small_vector &other) {
+    if (!is_inline() && !other.is_inline()) {
+        std::swap(_storage, other._storage);
+        std::swap(_size, other._size);
+        std::swap(_capacity, other._capacity);
+        return;
+    }
+
+    small_vector tmp(std::move(other));
+    other.steal(*this);
+    steal(tmp);
+}
+
+template<typename T, std::size_t N, typename Growth>
+small_vector<T, N, Growth>::~small_vector() {
+    clear();
+}
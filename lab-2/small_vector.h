@@ -0,0 +1,153 @@
+#ifndef VECTOR_SMALL_VECTOR_H
+#define VECTOR_SMALL_VECTOR_H
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include "vector.h"
+
+// vector that keeps up to N elements inside the object and moves them to the heap only beyond that.
+// Heap buffers grow and shrink by the same Growth policy as vector, and element shuffling shares
+// vector's storage.h helpers.
+template<typename T, std::size_t N, typename Growth = default_growth>
+struct small_vector {
+    static_assert(N > 0, "small_vector needs room for at least one inline element");
+
+public:
+    small_vector() noexcept;
+
+    explicit small_vector(std::size_t initial_size);
+
+    small_vector(const small_vector &other);
+
+    small_vector(small_vector &&other) noexcept(std::is_nothrow_move_constructible<T>::value);
+
+    small_vector &operator=(const small_vector &other);
+
+    small_vector &operator=(small_vector &&other) noexcept(std::is_nothrow_move_constructible<T>::value);
+
+    void push_back(const T &item);
+
+    void push_back(T &&item);
+
+    template<typename... Args>
+    T &emplace_back(Args &&... args);
+
+    void pop_back();
+
+    T &back();
+
+    const T &back() const;
+
+    T &operator[](std::size_t idx);
+
+    const T &operator[](std::size_t idx) const;
+
+    std::size_t size() const;
+
+    bool empty() const;
+
+    bool is_inline() const;
+
+    T *data();
+
+    const T *data() const;
+
+    void reserve(std::size_t new_capacity);
+
+    std::size_t capacity() const;
+
+    void shrink_to_fit();
+
+    void clear();
+
+    void resize(std::size_t new_size, T value = T());
+
+    ~small_vector();
+
+    // Iterators:
+
+    typedef T *iterator;
+    typedef const T *const_iterator;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    iterator begin();
+
+    const_iterator begin() const;
+
+    iterator end();
+
+    const_iterator end() const;
+
+    reverse_iterator rbegin();
+
+    const_reverse_iterator rbegin() const;
+
+    reverse_iterator rend();
+
+    const_reverse_iterator rend() const;
+
+    iterator insert(const_iterator pos, const T &value);
+
+    iterator insert(const_iterator pos, T &&value);
+
+    template<typename... Args>
+    iterator emplace(const_iterator pos, Args &&... args);
+
+    iterator erase(const_iterator pos);
+
+    iterator erase(const_iterator from, const_iterator to);
+
+    // Inserts [first, last) before pos, growing the buffer at most once and moving the tail once.
+    // The range must not point into this vector.
+    template<typename Iterator>
+    iterator insert(const_iterator pos, Iterator first, Iterator last);
+
+    template<typename Iterator>
+    void append(Iterator first, Iterator last);
+
+    // Removes every element matching pred in a single pass and returns how many were removed.
+    template<typename Predicate>
+    std::size_t erase_if(Predicate pred);
+
+    // Removes the element at pos by moving the last element into its place. Doesn't keep the order.
+    iterator swap_erase(const_iterator pos);
+
+    template<typename Iterator>
+    small_vector(Iterator first, Iterator last);
+
+    template<typename Iterator>
+    void assign(Iterator first, Iterator last);
+
+    void swap(small_vector &other);
+
+    friend void swap(small_vector &a, small_vector &b) {
+        a.swap(b);
+    }
+
+private:
+    std::size_t _size;
+    std::size_t _capacity;
+    T *_storage;
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type _inline[N];
+
+    T *inline_storage();
+
+    void increase_capacity();
+
+    void relocate(std::size_t new_capacity);
+
+    void steal(small_vector &other);
+
+    template<typename Iterator>
+    void insert_n(std::size_t idx, Iterator first, std::size_t cnt);
+
+    template<typename Iterator>
+    void insert_range(std::size_t idx, Iterator first, Iterator last, std::forward_iterator_tag);
+
+    template<typename Iterator>
+    void insert_range(std::size_t idx, Iterator first, Iterator last, std::input_iterator_tag);
+};
+
+#endif //VECTOR_SMALL_VECTOR_H
@@ -0,0 +1,208 @@
+#include <algorithm>
+#include <cassert>
+#include <tuple>
+#include <utility>
+#include "soa_vector.h"
+
+template<typename... Ts>
+soa_vector<Ts...>::soa_vector() noexcept : _size(0) {}
+
+template<typename... Ts>
+soa_vector<Ts...>::soa_vector(std::size_t initial_size) : soa_vector() {
+    resize(initial_size);
+}
+
+template<typename... Ts>
+void soa_vector<Ts...>::push_back(const value_type &item) {
+    std::apply([this](const Ts &... fields) { emplace_back(fields...); }, item);
+}
+
+template<typename... Ts>
+void soa_vector<Ts...>::push_back(value_type &&item) {
+    std::apply([this](Ts &... fields) { emplace_back(std::move(fields)...); }, item);
+}
+
+template<typename... Ts>
+template<typename... Args>
+typename soa_vector<Ts...>::reference soa_vector<Ts...>::emplace_back(Args &&... args) {
+    static_assert(sizeof...(Args) == sizeof...(Ts), "emplace_back takes one argument per column");
+    if (_size == capacity()) {
+        reserve(no_shrink_growth<>::grow(capacity()));
+    }
+    emplace_columns(columns(), std::forward<Args>(args)...);
+    _size++;
+    return back();
+}
+
+template<typename... Ts>
+template<std::size_t... I, typename... Args>
+void soa_vector<Ts...>::emplace_columns(std::index_sequence<I...>, Args &&... args) {
+    // Every column has room, so only an element constructor can throw; the columns filled
+    // before it are rolled back.
+    std::size_t filled = 0;
+    try {
+        ((std::get<I>(_columns).emplace_back(std::forward<Args>(args)), filled++), ...);
+    } catch (...) {
+        ((I < filled ? std::get<I>(_columns).pop_back() : void()), ...);
+        throw;
+    }
+}
+
+template<typename... Ts>
+void soa_vector<Ts...>::pop_back() {
+    assert(_size > 0);
+    std::apply([](auto &... column) { (column.pop_back(), ...); }, _columns);
+    _size--;
+}
+
+template<typename... Ts>
+typename soa_vector<Ts...>::reference soa_vector<Ts...>::back() {
+    assert(_size > 0);
+    return (*this)[_size - 1];
+}
+
+template<typename... Ts>
+typename soa_vector<Ts...>::const_reference soa_vector<Ts...>::back() const {
+    assert(_size > 0);
+    return (*this)[_size - 1];
+}
+
+template<typename... Ts>
+typename soa_vector<Ts...>::reference soa_vector<Ts...>::operator[](std::size_t idx) {
+    assert(idx < _size);
+    return at(idx, columns());
+}
+
+template<typename... Ts>
+typename soa_vector<Ts...>::const_reference soa_vector<Ts...>::operator[](std::size_t idx) const {
+    assert(idx < _size);
+    return at(idx, columns());
+}
+
+template<typename... Ts>
+template<std::size_t... I>
+typename soa_vector<Ts...>::reference soa_vector<Ts...>::at(std::size_t idx, std::index_sequence<I...>) {
+    return reference(std::get<I>(_columns)[idx]...);
+}
+
+template<typename... Ts>
+template<std::size_t... I>
+typename soa_vector<Ts...>::const_reference
+soa_vector<Ts...>::at(std::size_t idx, std::index_sequence<I...>) const {
+    return const_reference(std::get<I>(_columns)[idx]...);
+}
+
+template<typename... Ts>
+std::size_t soa_vector<Ts...>::size() const {
+    return _size;
+}
+
+template<typename... Ts>
+bool soa_vector<Ts...>::empty() const {
+    return _size == 0;
+}
+
+template<typename... Ts>
+template<std::size_t I>
+column_span<typename soa_vector<Ts...>::template column_type<I>> soa_vector<Ts...>::column() {
+    return column_span<column_type<I>>(std::get<I>(_columns).data(), _size);
+}
+
+template<typename... Ts>
+template<std::size_t I>
+column_span<const typename soa_vector<Ts...>::template column_type<I>> soa_vector<Ts...>::column() const {
+    return column_span<const column_type<I>>(std::get<I>(_columns).data(), _size);
+}
+
+template<typename... Ts>
+void soa_vector<Ts...>::reserve(std::size_t new_capacity) {
+    // If a column fails to grow, the ones before it keep their larger buffers; capacity()
+    // reports the smallest, so the next push_back tries again.
+    std::apply([new_capacity](auto &... column) { (column.reserve(new_capacity), ...); }, _columns);
+}
+
+template<typename... Ts>
+std::size_t soa_vector<Ts...>::capacity() const {
+    return std::apply([](const auto &... column) { return std::min({column.capacity()...}); }, _columns);
+}
+
+template<typename... Ts>
+void soa_vector<Ts...>::shrink_to_fit() {
+    std::apply([](auto &... column) { (column.shrink_to_fit(), ...); }, _columns);
+}
+
+template<typename... Ts>
+void soa_vector<Ts...>::clear() {
+    std::apply([](auto &... column) { (column.clear(), ...); }, _columns);
+    _size = 0;
+}
+
+template<typename... Ts>
+void soa_vector<Ts...>::resize(std::size_t new_size) {
+    if (new_size <= _size) {
+        truncate_columns(new_size, columns());
+        _size = new_size;
+        return;
+    }
+
+    reserve(new_size);
+    try {
+        std::apply([new_size](auto &... column) { (column.resize(new_size), ...); }, _columns);
+    } catch (...) {
+        truncate_columns(_size, columns());
+        throw;
+    }
+    _size = new_size;
+}
+
+template<typename... Ts>
+template<std::size_t... I>
+void soa_vector<Ts...>::truncate_columns(std::size_t new_size, std::index_sequence<I...>) {
+    (std::get<I>(_columns).resize(std::min(new_size, std::get<I>(_columns).size())), ...);
+}
+
+template<typename... Ts>
+typename soa_vector<Ts...>::iterator soa_vector<Ts...>::begin() {
+    return iterator(this, 0);
+}
+
+template<typename... Ts>
+typename soa_vector<Ts...>::const_iterator soa_vector<Ts...>::begin() const {
+    return const_iterator(this, 0);
+}
+
+template<typename... Ts>
+typename soa_vector<Ts...>::iterator soa_vector<Ts...>::end() {
+    return iterator(this, _size);
+}
+
+template<typename... Ts>
+typename soa_vector<Ts...>::const_iterator soa_vector<Ts...>::end() const {
+    return const_iterator(this, _size);
+}
+
+template<typename... Ts>
+typename soa_vector<Ts...>::reverse_iterator soa_vector<Ts...>::rbegin() {
+    return reverse_iterator(end());
+}
+
+template<typename... Ts>
+typename soa_vector<Ts...>::const_reverse_iterator soa_vector<Ts...>::rbegin() const {
+    return const_reverse_iterator(end());
+}
+
+template<typename... Ts>
+typename soa_vector<Ts...>::reverse_iterator soa_vector<Ts...>::rend() {
+    return reverse_iterator(begin());
+}
+
+template<typename... Ts>
+typename soa_vector<Ts...>::const_reverse_iterator soa_vector<Ts...>::rend() const {
+    return const_reverse_iterator(begin());
+}
+
+template<typename... Ts>
+void soa_vector<Ts...>::swap(soa_vector &other) noexcept {
+    _columns.swap(other._columns);
+    std::swap(_size, other._size);
+}
@@ -0,0 +1,261 @@
+#ifndef VECTOR_SOA_VECTOR_H
+#define VECTOR_SOA_VECTOR_H
+
+#include <cstddef>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "vector.h"
+
+// Contiguous view of one soa_vector column.
+template<typename T>
+struct column_span {
+    column_span(T *data, std::size_t size) : _data(data), _size(size) {}
+
+    T *data() const { return _data; }
+
+    std::size_t size() const { return _size; }
+
+    bool empty() const { return _size == 0; }
+
+    T &operator[](std::size_t idx) const { return _data[idx]; }
+
+    T *begin() const { return _data; }
+
+    T *end() const { return _data + _size; }
+
+private:
+    T *_data;
+    std::size_t _size;
+};
+
+// What soa_vector's operator[] and iterators return in place of T&: one reference per column.
+// Assigning through it writes the referenced elements, and swapping two of them swaps the
+// elements, so std::sort and friends work on soa_vector iterators. Converting to value_type
+// copies, so algorithms that move elements out (std::sort does) copy them instead.
+template<typename... Us>
+struct soa_reference {
+    typedef std::tuple<typename std::remove_const<Us>::type...> value_type;
+
+    explicit soa_reference(Us &... refs) : _refs(refs...) {}
+
+    soa_reference(const soa_reference &other) = default;
+
+    template<std::size_t I>
+    typename std::tuple_element<I, std::tuple<Us...>>::type &get() const { return std::get<I>(_refs); }
+
+    std::tuple<Us &...> tie() const { return _refs; }
+
+    operator value_type() const { return value_type(_refs); }
+
+    const soa_reference &operator=(const soa_reference &other) const {
+        _refs = other.tie();
+        return *this;
+    }
+
+    const soa_reference &operator=(const value_type &value) const {
+        _refs = value;
+        return *this;
+    }
+
+    const soa_reference &operator=(value_type &&value) const {
+        _refs = std::move(value);
+        return *this;
+    }
+
+    friend void swap(const soa_reference &a, const soa_reference &b) {
+        a.swap_elements(b, std::index_sequence_for<Us...>());
+    }
+
+    friend bool operator==(const soa_reference &a, const soa_reference &b) { return a.tie() == b.tie(); }
+
+    friend bool operator!=(const soa_reference &a, const soa_reference &b) { return a.tie() != b.tie(); }
+
+    friend bool operator<(const soa_reference &a, const soa_reference &b) { return a.tie() < b.tie(); }
+
+    friend bool operator==(const soa_reference &a, const value_type &b) { return a.tie() == b; }
+
+    friend bool operator<(const soa_reference &a, const value_type &b) { return a.tie() < b; }
+
+    friend bool operator<(const value_type &a, const soa_reference &b) { return a < b.tie(); }
+
+private:
+    // Assignment goes through to the elements, so it has to work on a const proxy.
+    mutable std::tuple<Us &...> _refs;
+
+    template<std::size_t... I>
+    void swap_elements(const soa_reference &other, std::index_sequence<I...>) const {
+        using std::swap;
+        (swap(std::get<I>(_refs), std::get<I>(other._refs)), ...);
+    }
+};
+
+// Structure of arrays: element i is the tuple (column<0>()[i], column<1>()[i], ...), and each
+// column is a contiguous vector of its own, so a loop over one field reads only that field.
+// All columns share one size and grow together to the same capacity. Columns never shrink
+// implicitly; use shrink_to_fit().
+template<typename... Ts>
+struct soa_vector {
+    static_assert(sizeof...(Ts) > 0, "soa_vector needs at least one column");
+
+public:
+    typedef std::tuple<Ts...> value_type;
+    typedef soa_reference<Ts...> reference;
+    typedef soa_reference<const Ts...> const_reference;
+
+    template<std::size_t I>
+    using column_type = typename std::tuple_element<I, value_type>::type;
+
+    soa_vector() noexcept;
+
+    explicit soa_vector(std::size_t initial_size);
+
+    void push_back(const value_type &item);
+
+    void push_back(value_type &&item);
+
+    // Takes one constructor argument per column.
+    template<typename... Args>
+    reference emplace_back(Args &&... args);
+
+    void pop_back();
+
+    reference back();
+
+    const_reference back() const;
+
+    reference operator[](std::size_t idx);
+
+    const_reference operator[](std::size_t idx) const;
+
+    std::size_t size() const;
+
+    bool empty() const;
+
+    template<std::size_t I>
+    column_span<column_type<I>> column();
+
+    template<std::size_t I>
+    column_span<const column_type<I>> column() const;
+
+    void reserve(std::size_t new_capacity);
+
+    std::size_t capacity() const;
+
+    void shrink_to_fit();
+
+    void clear();
+
+    void resize(std::size_t new_size);
+
+    // Iterators:
+
+    template<bool Const>
+    struct basic_iterator {
+        typedef std::random_access_iterator_tag iterator_category;
+        typedef std::tuple<Ts...> value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef void pointer;
+        typedef typename std::conditional<Const, soa_reference<const Ts...>, soa_reference<Ts...>>::type reference;
+        typedef typename std::conditional<Const, const soa_vector, soa_vector>::type owner;
+
+        basic_iterator() : _owner(nullptr), _idx(0) {}
+
+        basic_iterator(owner *o, std::size_t idx) : _owner(o), _idx(idx) {}
+
+        operator basic_iterator<true>() const { return basic_iterator<true>(_owner, _idx); }
+
+        reference operator*() const { return (*_owner)[_idx]; }
+
+        reference operator[](difference_type n) const { return (*_owner)[_idx + n]; }
+
+        basic_iterator &operator++() { ++_idx; return *this; }
+
+        basic_iterator operator++(int) { basic_iterator old = *this; ++_idx; return old; }
+
+        basic_iterator &operator--() { --_idx; return *this; }
+
+        basic_iterator operator--(int) { basic_iterator old = *this; --_idx; return old; }
+
+        basic_iterator &operator+=(difference_type n) { _idx += n; return *this; }
+
+        basic_iterator &operator-=(difference_type n) { _idx -= n; return *this; }
+
+        basic_iterator operator+(difference_type n) const { return basic_iterator(_owner, _idx + n); }
+
+        basic_iterator operator-(difference_type n) const { return basic_iterator(_owner, _idx - n); }
+
+        friend basic_iterator operator+(difference_type n, const basic_iterator &it) { return it + n; }
+
+        difference_type operator-(const basic_iterator &other) const {
+            return (difference_type) _idx - (difference_type) other._idx;
+        }
+
+        bool operator==(const basic_iterator &other) const { return _idx == other._idx; }
+
+        bool operator!=(const basic_iterator &other) const { return _idx != other._idx; }
+
+        bool operator<(const basic_iterator &other) const { return _idx < other._idx; }
+
+        bool operator>(const basic_iterator &other) const { return _idx > other._idx; }
+
+        bool operator<=(const basic_iterator &other) const { return _idx <= other._idx; }
+
+        bool operator>=(const basic_iterator &other) const { return _idx >= other._idx; }
+
+        std::size_t index() const { return _idx; }
+
+    private:
+        owner *_owner;
+        std::size_t _idx;
+    };
+
+    typedef basic_iterator<false> iterator;
+    typedef basic_iterator<true> const_iterator;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    iterator begin();
+
+    const_iterator begin() const;
+
+    iterator end();
+
+    const_iterator end() const;
+
+    reverse_iterator rbegin();
+
+    const_reverse_iterator rbegin() const;
+
+    reverse_iterator rend();
+
+    const_reverse_iterator rend() const;
+
+    void swap(soa_vector &other) noexcept;
+
+    friend void swap(soa_vector &a, soa_vector &b) noexcept {
+        a.swap(b);
+    }
+
+private:
+    typedef std::index_sequence_for<Ts...> columns;
+
+    // Growth happens here, for all columns at once; the columns' own policy never kicks in.
+    std::tuple<vector<Ts, no_shrink_growth<>>...> _columns;
+    std::size_t _size;
+
+    template<std::size_t... I>
+    reference at(std::size_t idx, std::index_sequence<I...>);
+
+    template<std::size_t... I>
+    const_reference at(std::size_t idx, std::index_sequence<I...>) const;
+
+    template<std::size_t... I, typename... Args>
+    void emplace_columns(std::index_sequence<I...>, Args &&... args);
+
+    template<std::size_t... I>
+    void truncate_columns(std::size_t new_size, std::index_sequence<I...>);
+};
+
+#endif //VECTOR_SOA_VECTOR_H
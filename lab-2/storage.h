@@ -0,0 +1,359 @@
+#ifndef VECTOR_STORAGE_H
+#define VECTOR_STORAGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Types whose objects can be moved to another address with a plain memcpy, leaving
+// nothing to destroy at the old one. vector grows buffers of such types in place with
+// realloc/mremap. Specialize it for types that own their resources through pointers.
+template<typename T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+// Whether buffers of T come from raw_alloc and are resized by raw_realloc. malloc and realloc
+// only guarantee alignof(std::max_align_t), so over-aligned types take aligned operator new and
+// are moved to a new buffer instead.
+template<typename T>
+struct uses_raw_storage : std::integral_constant<bool, is_trivially_relocatable<T>::value &&
+                                                       alignof(T) <= alignof(std::max_align_t)> {};
+
+// Buffers of at least this many bytes are mapped directly, so growing them remaps pages instead of copying.
+const std::size_t MMAP_THRESHOLD = std::size_t(1) << 21;
+
+inline bool is_mapped(std::size_t bytes) {
+#ifdef __linux__
+    return bytes >= MMAP_THRESHOLD;
+#else
+    return false;
+#endif
+}
+
+inline std::size_t page_round(std::size_t bytes) {
+#ifdef __linux__
+    static const std::size_t page_size = (std::size_t) sysconf(_SC_PAGESIZE);
+    return (bytes + page_size - 1) / page_size * page_size;
+#else
+    return bytes;
+#endif
+}
+
+#ifdef __linux__
+const std::size_t HUGE_PAGE_SIZE = std::size_t(2) << 20;
+
+// Asks for transparent huge pages, so that scanning a large buffer takes far fewer TLB misses.
+inline void advise_huge_pages(void *ptr, std::size_t bytes) {
+#ifdef MADV_HUGEPAGE
+    madvise(ptr, bytes, MADV_HUGEPAGE);
+#endif
+}
+
+// Maps zero-filled pages aligned to HUGE_PAGE_SIZE. Pages are only backed by memory once touched.
+inline void *map_pages(std::size_t bytes) {
+    std::size_t len = page_round(bytes);
+    auto *ptr = (char *) mmap(nullptr, len + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) throw std::bad_alloc();
+
+    auto *aligned = (char *) (((std::uintptr_t) ptr + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE);
+    if (aligned != ptr) munmap(ptr, aligned - ptr);
+    munmap(aligned + len, ptr + HUGE_PAGE_SIZE - aligned);
+
+    advise_huge_pages(aligned, len);
+    return aligned;
+}
+#endif
+
+inline void *raw_alloc(std::size_t bytes) {
+    if (bytes == 0) return nullptr;
+#ifdef __linux__
+    if (is_mapped(bytes)) return map_pages(bytes);
+#endif
+    void *ptr = malloc(bytes);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+inline void raw_free(void *ptr, std::size_t bytes) {
+    if (!ptr) return;
+#ifdef __linux__
+    if (is_mapped(bytes)) {
+        munmap(ptr, page_round(bytes));
+        return;
+    }
+#endif
+    free(ptr);
+}
+
+// Resizes a raw_alloc'ed block keeping its first `used_bytes`. On failure throws and leaves the block untouched.
+inline void *raw_realloc(void *ptr, std::size_t old_bytes, std::size_t new_bytes, std::size_t used_bytes) {
+    if (!ptr) return raw_alloc(new_bytes);
+    if (new_bytes == 0) {
+        raw_free(ptr, old_bytes);
+        return nullptr;
+    }
+
+    void *new_ptr;
+#ifdef __linux__
+    if (is_mapped(old_bytes) && is_mapped(new_bytes)) {
+        new_ptr = mremap(ptr, page_round(old_bytes), page_round(new_bytes), MREMAP_MAYMOVE);
+        if (new_ptr == MAP_FAILED) throw std::bad_alloc();
+        if (new_bytes > old_bytes) advise_huge_pages(new_ptr, page_round(new_bytes));
+        return new_ptr;
+    }
+    if (is_mapped(old_bytes) || is_mapped(new_bytes)) {
+        new_ptr = raw_alloc(new_bytes);
+        memcpy(new_ptr, ptr, used_bytes);
+        raw_free(ptr, old_bytes);
+        return new_ptr;
+    }
+#endif
+    new_ptr = realloc(ptr, new_bytes);
+    if (!new_ptr) throw std::bad_alloc();
+    return new_ptr;
+}
+
+// Gives the pages of a mapped block past `used_bytes` back to the kernel. They read as zeros afterwards.
+inline void raw_release_tail(void *ptr, std::size_t used_bytes, std::size_t bytes) {
+#ifdef __linux__
+    if (!is_mapped(bytes)) return;
+    std::size_t from = page_round(used_bytes);
+    std::size_t to = page_round(bytes);
+    if (from < to) madvise((char *) ptr + from, to - from, MADV_DONTNEED);
+#endif
+}
+
+template<typename T>
+typename std::enable_if<std::is_trivially_destructible<T>::value>::type smart_destroy(T *, std::size_t) {
+}
+
+template<typename T>
+typename std::enable_if<!std::is_trivially_destructible<T>::value>::type smart_destroy(T *ptr, std::size_t cnt) {
+    for (std::size_t i = 0; i < cnt; i++) {
+        ptr[i].~T();
+    }
+}
+
+template<typename T>
+typename std::enable_if<std::is_trivially_copyable<T>::value>::type smart_copy(const T *from, T *to, std::size_t cnt) {
+    if (cnt > 0) memcpy(to, from, cnt * sizeof(T));
+}
+
+template<typename T>
+typename std::enable_if<!std::is_trivially_copyable<T>::value>::type smart_copy(const T *from, T *to, std::size_t cnt) {
+    std::size_t i = 0;
+    try {
+        for (; i < cnt; i++) {
+            new(&to[i]) T(from[i]);
+        }
+    } catch (...) {
+        smart_destroy(to, i);
+        throw;
+    }
+}
+
+// Moves `cnt` elements into uninitialized memory, falling back to copying when
+// T's move constructor may throw, so that a failed relocation leaves `from` intact.
+// The source elements are left alive; the caller destroys them.
+template<typename T>
+typename std::enable_if<std::is_trivially_copyable<T>::value>::type smart_move(T *from, T *to, std::size_t cnt) {
+    if (cnt > 0) memcpy(to, from, cnt * sizeof(T));
+}
+
+template<typename T>
+typename std::enable_if<!std::is_trivially_copyable<T>::value>::type smart_move(T *from, T *to, std::size_t cnt) {
+    std::size_t i = 0;
+    try {
+        for (; i < cnt; i++) {
+            new(&to[i]) T(std::move_if_noexcept(from[i]));
+        }
+    } catch (...) {
+        smart_destroy(to, i);
+        throw;
+    }
+}
+
+// Copy-constructs `cnt` elements read from `first` into uninitialized memory.
+template<typename T, typename Iterator>
+typename std::enable_if<!std::is_convertible<Iterator, const T *>::value>::type smart_copy_n(
+        Iterator first, std::size_t cnt, T *to) {
+    std::uninitialized_copy_n(first, cnt, to);
+}
+
+template<typename T>
+void smart_copy_n(const T *first, std::size_t cnt, T *to) {
+    smart_copy(first, to, cnt);
+}
+
+// Moves `cnt` live elements down from `from` onto the live elements at `to` (to < from).
+template<typename T>
+typename std::enable_if<std::is_trivially_copyable<T>::value>::type smart_shift_down(T *from, T *to, std::size_t cnt) {
+    if (cnt > 0) memmove(to, from, cnt * sizeof(T));
+}
+
+template<typename T>
+typename std::enable_if<!std::is_trivially_copyable<T>::value>::type smart_shift_down(T *from, T *to, std::size_t cnt) {
+    std::move(from, from + cnt, to);
+}
+
+// Inserts cnt elements read from `first` at idx of a buffer holding `size` live elements and room
+// for cnt more. Each element past idx is moved once.
+template<typename T, typename Iterator>
+void smart_insert_n(T *storage, std::size_t size, std::size_t idx, Iterator first, std::size_t cnt) {
+    std::size_t tail = size - idx;
+    if constexpr (std::is_trivially_copyable<T>::value) {
+        memmove(storage + idx + cnt, storage + idx, tail * sizeof(T));
+        smart_copy_n(first, cnt, storage + idx);
+    } else if (tail > cnt) {
+        std::uninitialized_move(storage + size - cnt, storage + size, storage + size);
+        std::move_backward(storage + idx, storage + size - cnt, storage + size);
+        std::copy_n(first, cnt, storage + idx);
+    } else {
+        Iterator mid = std::next(first, tail);
+        smart_copy_n(mid, cnt - tail, storage + size);
+        try {
+            std::uninitialized_move(storage + idx, storage + size, storage + idx + cnt);
+        } catch (...) {
+            smart_destroy(storage + size, cnt - tail);
+            throw;
+        }
+        std::copy(first, mid, storage + idx);
+    }
+}
+
+// Fills the uninitialized buffer `to` with the `size` elements of `from` and cnt elements read from
+// `first` inserted at idx. On failure `to` is left empty. The elements of `from` stay alive either
+// way; the caller destroys them.
+template<typename T, typename Iterator>
+void smart_insert_into(T *from, std::size_t size, std::size_t idx, Iterator first, std::size_t cnt, T *to) {
+    std::size_t constructed = 0;
+    try {
+        smart_copy_n(first, cnt, to + idx);
+        constructed = cnt;
+        smart_move(from, to, idx);
+        constructed += idx;
+        smart_move(from + idx, to + idx + cnt, size - idx);
+    } catch (...) {
+        if (constructed > 0) smart_destroy(to + idx, cnt);
+        if (constructed > cnt) smart_destroy(to, idx);
+        throw;
+    }
+}
+
+// Moves item to idx < size of a buffer with room for one more element, counting the element it
+// adds in `size` as soon as it exists.
+template<typename T>
+void smart_emplace_at(T *storage, std::size_t &size, std::size_t idx, T &item) {
+    new(&storage[size]) T(std::move(storage[size - 1]));
+    size++;
+    std::move_backward(storage + idx, storage + size - 2, storage + size - 1);
+    storage[idx] = std::move(item);
+}
+
+// Removes [from, to) of the `size` live elements, shifting the rest down. Returns the new size.
+template<typename T>
+std::size_t smart_erase(T *storage, std::size_t size, std::size_t from, std::size_t to) {
+    std::size_t diff = to - from;
+    smart_shift_down(storage + to, storage + from, size - to);
+    smart_destroy(storage + size - diff, diff);
+    return size - diff;
+}
+
+// Removes the elements matching pred in one pass. Returns the new size.
+template<typename T, typename Predicate>
+std::size_t smart_erase_if(T *storage, std::size_t size, Predicate pred) {
+    T *kept = std::remove_if(storage, storage + size, pred);
+    std::size_t removed = storage + size - kept;
+    smart_destroy(kept, removed);
+    return size - removed;
+}
+
+// Removes the element at idx by moving the last one into its place. Returns the new size.
+template<typename T>
+std::size_t smart_swap_erase(T *storage, std::size_t size, std::size_t idx) {
+    if (idx != size - 1) storage[idx] = std::move(storage[size - 1]);
+    storage[size - 1].~T();
+    return size - 1;
+}
+
+template<typename T>
+typename std::enable_if<uses_raw_storage<T>::value, T *>::type smart_alloc(std::size_t capacity) {
+    return (T *) raw_alloc(capacity * sizeof(T));
+}
+
+template<typename T>
+typename std::enable_if<!uses_raw_storage<T>::value, T *>::type smart_alloc(std::size_t capacity) {
+    if (capacity == 0) return nullptr;
+    if (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+        return (T *) operator new(capacity * sizeof(T), std::align_val_t(alignof(T)));
+    }
+    return (T *) operator new(capacity * sizeof(T));
+}
+
+template<typename T>
+typename std::enable_if<uses_raw_storage<T>::value>::type smart_free(T *ptr, std::size_t capacity) {
+    raw_free(ptr, capacity * sizeof(T));
+}
+
+template<typename T>
+typename std::enable_if<!uses_raw_storage<T>::value>::type smart_free(T *ptr, std::size_t) {
+    if (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+        operator delete(ptr, std::align_val_t(alignof(T)));
+    } else {
+        operator delete(ptr);
+    }
+}
+
+// Moves `size` live elements from a buffer of `old_capacity` into one of `new_capacity` and releases the old buffer.
+template<typename T>
+typename std::enable_if<uses_raw_storage<T>::value, T *>::type smart_relocate(
+        T *ptr, std::size_t size, std::size_t old_capacity, std::size_t new_capacity) {
+    return (T *) raw_realloc(ptr, old_capacity * sizeof(T), new_capacity * sizeof(T), size * sizeof(T));
+}
+
+template<typename T>
+typename std::enable_if<!uses_raw_storage<T>::value, T *>::type smart_relocate(
+        T *ptr, std::size_t size, std::size_t old_capacity, std::size_t new_capacity) {
+    T *new_ptr = smart_alloc<T>(new_capacity);
+    try {
+        smart_move(ptr, new_ptr, size);
+    } catch (...) {
+        smart_free(new_ptr, new_capacity);
+        throw;
+    }
+    smart_destroy(ptr, size);
+    smart_free(ptr, old_capacity);
+    return new_ptr;
+}
+
+// Whether a buffer of `capacity` elements from smart_alloc is an anonymous mapping. Growing such a
+// buffer with smart_relocate only adds zero-filled pages past the old capacity.
+template<typename T>
+bool smart_is_mapped(std::size_t capacity) {
+    return uses_raw_storage<T>::value && is_mapped(capacity * sizeof(T));
+}
+
+template<typename T>
+void smart_release_tail(T *ptr, std::size_t size, std::size_t capacity) {
+    if (uses_raw_storage<T>::value) raw_release_tail(ptr, size * sizeof(T), capacity * sizeof(T));
+}
+
+template<typename T>
+void smart_delete(T *ptr, std::size_t size, std::size_t capacity) {
+    smart_destroy(ptr, size);
+    smart_free(ptr, capacity);
+}
+
+#endif //VECTOR_STORAGE_H
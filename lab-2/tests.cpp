@@ -1,8 +1,36 @@
 #include <iostream>
 #include <cstddef>
+#include <sstream>
+#include <vector>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <deque>
 #include "gtest/gtest.h"
 #include "vector.h"
 #include "vector.cpp"
+#include "memory_resource.h"
+#include "memory_resource.cpp"
+#include "small_vector.h"
+#include "small_vector.cpp"
+#include "cow_vector.h"
+#include "cow_vector.cpp"
+#include "simd.h"
+#include "simd.cpp"
+#include "thread_pool.h"
+#include "thread_pool.cpp"
+#include "parallel.h"
+#include "parallel.cpp"
+#include "concurrent_vector.h"
+#include "concurrent_vector.cpp"
+#include "segmented_vector.h"
+#include "segmented_vector.cpp"
+#include "vector_stats.h"
+#include "vector_stats.cpp"
+#include "mapped_vector.h"
+#include "mapped_vector.cpp"
+#include "soa_vector.h"
+#include "soa_vector.cpp"
 
 TEST(basic, push_pop_size_back) {
     vector<int> v;
@@ -190,4 +218,888 @@ struct throws {
 
 TEST(basic, init_throws) {
     ASSERT_THROW(vector<throws> v(10), std::runtime_error);
-}
\ No newline at end of file
+}
+
+TEST(no_sfinae, strings_grow) {
+    vector<std::string> v;
+    for (int i = 0; i < 1000; i++) {
+        v.push_back(std::string(32, 'a' + i % 26));
+    }
+    ASSERT_EQ(1000, v.size());
+    for (int i = 0; i < 1000; i++) {
+        ASSERT_EQ(std::string(32, 'a' + i % 26), v[i]);
+    }
+
+    v.insert(v.begin() + 1, std::string("qwe"));
+    ASSERT_EQ("qwe", v[1]);
+    ASSERT_EQ(std::string(32, 'b'), v[2]);
+
+    v.erase(v.begin(), v.begin() + 500);
+    ASSERT_EQ(501, v.size());
+    v.shrink_to_fit();
+    ASSERT_EQ(501, v.capacity());
+}
+
+struct move_only {
+    explicit move_only(int value) : value(new int(value)) {}
+    move_only(move_only &&other) noexcept : value(other.value) { other.value = nullptr; }
+    move_only &operator=(move_only &&other) noexcept {
+        std::swap(value, other.value);
+        return *this;
+    }
+    ~move_only() { delete value; }
+
+    int *value;
+};
+
+TEST(move, emplace_back) {
+    vector<move_only> v;
+    for (int i = 0; i < 100; i++) {
+        ASSERT_EQ(i, *v.emplace_back(i).value);
+    }
+    v.push_back(move_only(100));
+    v.emplace(v.begin(), -1);
+    v.insert(v.begin() + 50, move_only(1000));
+
+    ASSERT_EQ(103, v.size());
+    ASSERT_EQ(-1, *v[0].value);
+    ASSERT_EQ(1000, *v[50].value);
+    ASSERT_EQ(100, *v.back().value);
+}
+
+TEST(move, move_init_assign) {
+    vector<std::string> v1;
+    v1.push_back("abc");
+    const std::string *data = v1.data();
+
+    vector<std::string> v2(std::move(v1));
+    ASSERT_TRUE(v1.empty());
+    ASSERT_EQ(data, v2.data());
+
+    vector<std::string> v3;
+    v3.push_back("qwe");
+    v3 = std::move(v2);
+    ASSERT_EQ(1, v3.size());
+    ASSERT_EQ("abc", v3[0]);
+    ASSERT_EQ(data, v3.data());
+}
+
+TEST(relocatable, grow_past_mmap_threshold) {
+    vector<int> v;
+    for (int i = 0; i < (1 << 21); i++) {
+        v.push_back(i);
+    }
+    for (int i = 0; i < (1 << 21); i += 4099) {
+        ASSERT_EQ(i, v[i]);
+    }
+
+    v.resize(100);
+    v.shrink_to_fit();
+    ASSERT_EQ(100, v.capacity());
+    ASSERT_EQ(99, v.back());
+}
+
+struct alignas(64) cache_line {
+    int value;
+};
+
+TEST(relocatable, over_aligned_elements) {
+    vector<cache_line> v;
+    for (int i = 0; i < 100000; i++) {
+        v.push_back(cache_line{i});
+        ASSERT_EQ(0, (std::uintptr_t) v.data() % 64);
+    }
+    for (int i = 0; i < 100000; i += 97) {
+        ASSERT_EQ(i, v[i].value);
+    }
+    v.resize(10);
+    v.shrink_to_fit();
+    ASSERT_EQ(0, (std::uintptr_t) v.data() % 64);
+    ASSERT_EQ(9, v.back().value);
+}
+
+TEST(small_vector, inline_then_heap) {
+    small_vector<std::string, 4> v;
+    for (int i = 0; i < 4; i++) {
+        v.push_back(std::to_string(i));
+    }
+    ASSERT_TRUE(v.is_inline());
+    ASSERT_EQ(4, v.capacity());
+
+    v.push_back("4");
+    ASSERT_FALSE(v.is_inline());
+    v.insert(v.begin(), "-1");
+    v.erase(v.begin() + 1);
+    ASSERT_EQ(5, v.size());
+    ASSERT_EQ("-1", v[0]);
+    ASSERT_EQ("4", v.back());
+
+    v.pop_back();
+    v.pop_back();
+    v.shrink_to_fit();
+    ASSERT_TRUE(v.is_inline());
+    ASSERT_EQ("2", v.back());
+}
+
+TEST(small_vector, copy_swap_mixed) {
+    small_vector<std::string, 2> a, b;
+    a.push_back("a");
+    for (int i = 0; i < 10; i++) {
+        b.push_back(std::to_string(i));
+    }
+
+    small_vector<std::string, 2> c = b;
+    ASSERT_EQ(10, c.size());
+    ASSERT_EQ("9", c.back());
+
+    swap(a, b);
+    ASSERT_EQ(10, a.size());
+    ASSERT_EQ(1, b.size());
+    ASSERT_EQ("a", b[0]);
+    ASSERT_TRUE(b.is_inline());
+
+    c = b;
+    ASSERT_EQ(1, c.size());
+    ASSERT_TRUE(c.is_inline());
+
+    small_vector<std::string, 2> d(std::move(a));
+    ASSERT_TRUE(a.empty());
+    ASSERT_EQ("9", d.back());
+}
+
+TEST(small_vector, bulk_and_growth) {
+    small_vector<std::string, 4, no_shrink_growth<3, 2>> v;
+    std::vector<std::string> expected;
+    std::vector<std::string> items = {"a", "b", "c"};
+    v.append(items.begin(), items.end());
+    expected.insert(expected.end(), items.begin(), items.end());
+    ASSERT_TRUE(v.is_inline());
+
+    std::vector<std::string> more;
+    for (int i = 0; i < 20; i++) {
+        more.push_back(std::to_string(i));
+    }
+    v.insert(v.begin() + 1, more.begin(), more.begin() + 2);
+    expected.insert(expected.begin() + 1, more.begin(), more.begin() + 2);
+    ASSERT_FALSE(v.is_inline());
+    ASSERT_EQ(6, v.capacity());
+
+    v.insert(v.begin() + 2, more.begin(), more.end());
+    expected.insert(expected.begin() + 2, more.begin(), more.end());
+    std::istringstream words("x y z");
+    v.insert(v.begin(), std::istream_iterator<std::string>(words), std::istream_iterator<std::string>());
+    expected.insert(expected.begin(), {"x", "y", "z"});
+    ASSERT_EQ(expected, std::vector<std::string>(v.begin(), v.end()));
+
+    auto odd = [](const std::string &s) { return s.size() == 1 && isdigit(s[0]) && (s[0] - '0') % 2 == 1; };
+    auto kept = std::remove_if(expected.begin(), expected.end(), odd);
+    ASSERT_EQ(expected.end() - kept, v.erase_if(odd));
+    expected.erase(kept, expected.end());
+    v.erase(v.begin(), v.begin() + 2);
+    expected.erase(expected.begin(), expected.begin() + 2);
+    ASSERT_EQ(expected, std::vector<std::string>(v.begin(), v.end()));
+
+    v.swap_erase(v.begin());
+    ASSERT_EQ(expected.back(), v[0]);
+    ASSERT_EQ(expected.size() - 1, v.size());
+
+    small_vector<int, 8> ints;
+    int numbers[] = {1, 2, 3, 4, 5};
+    ints.append(numbers, numbers + 5);
+    ints.insert(ints.begin() + 2, numbers, numbers + 5);
+    ASSERT_FALSE(ints.is_inline());
+    std::vector<int> want = {1, 2, 1, 2, 3, 4, 5, 3, 4, 5};
+    ASSERT_EQ(want, std::vector<int>(ints.begin(), ints.end()));
+}
+
+TEST(cow_vector, copy_shares_until_write) {
+    cow_vector<std::string> a;
+    for (int i = 0; i < 100; i++) {
+        a.push_back(std::to_string(i));
+    }
+
+    cow_vector<std::string> b = a;
+    const auto &cb = b;
+    ASSERT_FALSE(a.unique());
+    ASSERT_EQ(static_cast<const cow_vector<std::string> &>(a).data(), cb.data());
+    ASSERT_EQ("42", cb[42]);
+
+    b[0] = "zero";
+    ASSERT_TRUE(a.unique());
+    ASSERT_TRUE(b.unique());
+    ASSERT_EQ("0", a[0]);
+    ASSERT_EQ("zero", b[0]);
+
+    cow_vector<std::string> c = a;
+    c.erase(static_cast<const cow_vector<std::string> &>(c).begin() + 1);
+    c.insert(static_cast<const cow_vector<std::string> &>(c).begin(), "first");
+    ASSERT_EQ(100, a.size());
+    ASSERT_EQ("1", a[1]);
+    ASSERT_EQ("first", c[0]);
+    ASSERT_EQ("2", c[2]);
+}
+
+TEST(cow_vector, reference_outlives_copy) {
+    cow_vector<std::string> a;
+    a.push_back("a");
+    a.push_back("b");
+
+    std::string &r = a[0];
+    cow_vector<std::string> b = a;
+    r = "x";
+    ASSERT_EQ("x", static_cast<const cow_vector<std::string> &>(a)[0]);
+    ASSERT_EQ("a", static_cast<const cow_vector<std::string> &>(b)[0]);
+    ASSERT_TRUE(a.unique());
+
+    // A fresh buffer can be shared again.
+    a.clear();
+    a.push_back("y");
+    cow_vector<std::string> d = a;
+    ASSERT_FALSE(a.unique());
+
+    for (auto &item : b) {
+        item += "!";
+    }
+    cow_vector<std::string> e = b;
+    ASSERT_TRUE(b.unique());
+    b.make_shareable();
+    cow_vector<std::string> f = b;
+    ASSERT_FALSE(b.unique());
+    ASSERT_EQ("a!", static_cast<const cow_vector<std::string> &>(f)[0]);
+
+    // The copy made while the buffer couldn't be shared can be.
+    d = e;
+    ASSERT_FALSE(e.unique());
+}
+
+TEST(memory_resource, arena) {
+    monotonic_arena arena(1024);
+    {
+        vector<std::string> v(&arena);
+        vector<int> w(&arena);
+        for (int i = 0; i < 1000; i++) {
+            v.push_back(std::to_string(i));
+            w.push_back(i);
+        }
+        ASSERT_EQ(&arena, v.resource());
+        ASSERT_EQ("999", v.back());
+        ASSERT_EQ(999, w.back());
+
+        vector<std::string> copy = v;
+        ASSERT_EQ(nullptr, copy.resource());
+        copy = v;
+        ASSERT_EQ("0", copy[0]);
+
+        vector<std::string> moved(std::move(v));
+        ASSERT_EQ(&arena, moved.resource());
+    }
+    ASSERT_GT(arena.reserved(), 0);
+    arena.release();
+    ASSERT_EQ(0, arena.reserved());
+}
+
+TEST(memory_resource, arena_grows_in_place) {
+    monotonic_arena arena(4096);
+    vector<int> v(&arena);
+    v.push_back(0);
+    const int *first = v.data();
+    for (int i = 1; i < 512; i++) {
+        v.push_back(i);
+    }
+    ASSERT_EQ(first, v.data());
+    ASSERT_EQ(4096, arena.reserved());
+    for (int i = 0; i < 512; i++) {
+        ASSERT_EQ(i, v[i]);
+    }
+
+    // Another allocation after it leaves nothing to extend.
+    vector<int> w(&arena);
+    w.push_back(1);
+    v.reserve(v.capacity() + 1);
+    ASSERT_NE(first, v.data());
+    ASSERT_EQ(511, v.back());
+}
+
+TEST(memory_resource, thread_local_pool) {
+    vector<int> v(thread_local_pool());
+    for (int i = 0; i < 100; i++) {
+        v.push_back(i);
+    }
+    while (!v.empty()) {
+        v.pop_back();
+    }
+    ASSERT_EQ(thread_local_pool(), v.resource());
+}
+
+TEST(growth, oscillation_keeps_capacity) {
+    vector<int> v;
+    for (int i = 0; i < 1024; i++) {
+        v.push_back(i);
+    }
+    ASSERT_EQ(1024, v.capacity());
+
+    v.push_back(1024);
+    std::size_t capacity = v.capacity();
+    for (int i = 0; i < 100; i++) {
+        v.pop_back();
+        v.push_back(i);
+        ASSERT_EQ(capacity, v.capacity());
+    }
+}
+
+TEST(growth, custom_policy) {
+    vector<int, geometric_growth<3, 2, 4>> v;
+    for (int i = 0; i < 10; i++) {
+        v.push_back(i);
+    }
+    ASSERT_EQ(13, v.capacity());
+
+    vector<int, no_shrink_growth<>> w(1000);
+    while (!w.empty()) {
+        w.pop_back();
+    }
+    ASSERT_EQ(1000, w.capacity());
+}
+
+TEST(bulk, insert_append_range) {
+    std::vector<std::string> src = {"a", "b", "c"};
+    vector<std::string> v;
+    std::vector<std::string> expected;
+    auto insert_both = [&](std::size_t idx, std::size_t cnt) {
+        v.insert(v.begin() + idx, src.begin(), src.begin() + cnt);
+        expected.insert(expected.begin() + idx, src.begin(), src.begin() + cnt);
+    };
+
+    v.append(src.begin(), src.end());
+    expected.insert(expected.end(), src.begin(), src.end());
+    insert_both(1, 3);
+    insert_both(5, 1);
+    v.reserve(100);
+    insert_both(1, 3);
+    insert_both(9, 3);
+    insert_both(2, 2);
+    insert_both(v.size(), 3);
+
+    ASSERT_EQ(expected.size(), v.size());
+    for (std::size_t i = 0; i < expected.size(); i++) {
+        ASSERT_EQ(expected[i], v[i]);
+    }
+
+    int a[] = {1, 2, 3, 4};
+    vector<int> w(a, a + 4);
+    ASSERT_EQ(4, w.capacity());
+    w.insert(w.begin() + 2, a, a + 4);
+    int expected_ints[] = {1, 2, 1, 2, 3, 4, 3, 4};
+    ASSERT_TRUE(std::equal(w.begin(), w.end(), expected_ints));
+
+    std::istringstream in("5 6");
+    w.insert(w.begin(), std::istream_iterator<int>(in), std::istream_iterator<int>());
+    ASSERT_EQ(5, w[0]);
+    ASSERT_EQ(6, w[1]);
+    ASSERT_EQ(1, w[2]);
+}
+
+TEST(bulk, erase_if_swap_erase) {
+    vector<std::string> v;
+    for (int i = 0; i < 100; i++) {
+        v.push_back(std::to_string(i));
+    }
+    ASSERT_EQ(50, v.erase_if([](const std::string &s) { return (s.back() - '0') % 2 == 1; }));
+    ASSERT_EQ(50, v.size());
+    ASSERT_EQ("2", v[1]);
+
+    v.swap_erase(v.begin());
+    ASSERT_EQ(49, v.size());
+    ASSERT_EQ("98", v[0]);
+    v.swap_erase(v.end() - 1);
+    ASSERT_EQ("94", v.back());
+}
+
+template<typename T>
+void check_simd_kernels() {
+    std::mt19937 gen(566);
+    std::uniform_int_distribution<int> dist(-1000, 1000);
+
+    for (std::size_t n : {0, 1, 7, 31, 100, 1025}) {
+        vector<T> a, b, out;
+        for (std::size_t i = 0; i < n; i++) {
+            a.push_back((T) dist(gen));
+            b.push_back((T) dist(gen));
+        }
+        const T *pa = a.data();
+
+        T value = n > 0 ? a[n / 2] : T();
+        ASSERT_EQ(std::find(pa, pa + n, value) - pa, simd::find(a, value));
+        ASSERT_EQ(n, simd::find(a, (T) 5000));
+        ASSERT_EQ(std::count(pa, pa + n, value), simd::count(a, value));
+        if (n > 0) {
+            ASSERT_EQ(std::min_element(pa, pa + n) - pa, simd::min_element(a));
+            ASSERT_EQ(std::max_element(pa, pa + n) - pa, simd::max_element(a));
+        }
+        // Vectorized reductions add floating point values in a different order.
+        double sum = std::accumulate(pa, pa + n, T());
+        double dot = std::inner_product(pa, pa + n, b.data(), T());
+        ASSERT_NEAR(sum, simd::sum(a), std::abs(sum) * 1e-5);
+        ASSERT_NEAR(dot, simd::dot(a, b), std::abs(dot) * 1e-5);
+
+        simd::transform(a, b, out, simd::op::max);
+        for (std::size_t i = 0; i < n; i++) {
+            ASSERT_EQ(std::max(a[i], b[i]), out[i]);
+        }
+        simd::transform(a, b, out, simd::op::sub);
+        for (std::size_t i = 0; i < n; i++) {
+            ASSERT_EQ(a[i] - b[i], out[i]);
+        }
+    }
+}
+
+TEST(simd, matches_std_on_every_isa) {
+    for (auto level : {simd::isa::scalar, simd::isa::sse2, simd::isa::avx2, simd::isa::avx512}) {
+        simd::use_isa(level);
+        check_simd_kernels<std::int32_t>();
+        check_simd_kernels<float>();
+        check_simd_kernels<double>();
+        check_simd_kernels<long>();
+    }
+    simd::use_isa(simd::detected_isa());
+}
+
+TEST(mapped, lazy_zero_resize) {
+    vector<long long> v;
+    v.push_back(1);
+    v.resize(1 << 22);
+    ASSERT_EQ(1, v[0]);
+    for (std::size_t i = 1; i < v.size(); i += 4093) {
+        ASSERT_EQ(0, v[i]);
+    }
+
+    for (std::size_t i = 0; i < v.size(); i++) {
+        v[i] = 7;
+    }
+    v.resize(10);
+    ASSERT_EQ(7, v.back());
+    v.resize(1 << 22);
+    ASSERT_EQ(7, v[9]);
+    for (std::size_t i = 10; i < v.size(); i += 4093) {
+        ASSERT_EQ(0, v[i]);
+    }
+
+    vector<double> w(1 << 20);
+    ASSERT_EQ(0.0, w[12345]);
+    ASSERT_EQ(1 << 20, w.capacity());
+}
+
+// Pages of the buffer the process has touched.
+template<typename V>
+std::size_t resident_pages(const V &v) {
+    std::size_t page = (std::size_t) sysconf(_SC_PAGESIZE);
+    auto from = (std::uintptr_t) v.data() / page * page;
+    std::size_t length = (std::uintptr_t) (v.data() + v.size()) - from;
+    std::vector<unsigned char> pages((length + page - 1) / page);
+    if (mincore((void *) from, length, pages.data()) != 0) return SIZE_MAX;
+    return (std::size_t) std::count_if(pages.begin(), pages.end(), [](unsigned char p) { return p & 1; });
+}
+
+TEST(mapped, sized_constructor_touches_nothing) {
+    const std::size_t n = std::size_t(1) << 24;
+    vector<int> v(n);
+    ASSERT_EQ(n, v.size());
+    ASSERT_EQ(0, resident_pages(v));
+
+    vector<int> w;
+    w.reserve(n);
+    w.resize(n);
+    ASSERT_EQ(0, resident_pages(w));
+    ASSERT_EQ(0, w[n / 2]);
+
+    cow_vector<int> c(n);
+    ASSERT_EQ(0, resident_pages(static_cast<const cow_vector<int> &>(c)));
+
+    // Written elements are cleared when the vector grows back over them.
+    w[n - 1] = 5;
+    w.erase(w.end() - 1);
+    w.resize(n);
+    ASSERT_EQ(0, w[n - 1]);
+}
+
+TEST(parallel, algorithms_match_serial) {
+    thread_pool pool(4);
+    std::mt19937 gen(228);
+
+    vector<std::pair<int, int>> pairs;
+    vector<int> v;
+    for (int i = 0; i < 300000; i++) {
+        v.push_back((int) (gen() % 100000));
+        pairs.push_back(std::make_pair((int) (gen() % 100), i));
+    }
+
+    vector<int> sorted = v;
+    parallel::sort(sorted, std::less<int>(), pool);
+    std::vector<int> expected(v.begin(), v.end());
+    std::sort(expected.begin(), expected.end());
+    ASSERT_TRUE(std::equal(expected.begin(), expected.end(), sorted.begin()));
+
+    auto by_first = [](const std::pair<int, int> &a, const std::pair<int, int> &b) { return a.first < b.first; };
+    parallel::stable_sort(pairs, by_first, pool);
+    for (std::size_t i = 1; i < pairs.size(); i++) {
+        ASSERT_TRUE(pairs[i - 1].first < pairs[i].first ||
+                    (pairs[i - 1].first == pairs[i].first && pairs[i - 1].second < pairs[i].second));
+    }
+
+    vector<long long> squares;
+    parallel::transform(v, squares, [](int x) { return (long long) x * x; }, pool);
+    ASSERT_EQ((long long) v[1234] * v[1234], squares[1234]);
+
+    parallel::for_each(squares, [](long long &x) { x = -x; }, pool);
+    long long total = parallel::reduce(squares, 0LL, std::plus<long long>(), false, pool);
+    ASSERT_EQ(std::accumulate(squares.begin(), squares.end(), 0LL), total);
+
+    vector<long long> prefix;
+    parallel::inclusive_scan(squares, prefix, std::plus<long long>(), pool);
+    ASSERT_EQ(squares[0], prefix[0]);
+    ASSERT_EQ(total, prefix.back());
+    ASSERT_EQ(std::accumulate(squares.begin(), squares.begin() + 100001, 0LL), prefix[100000]);
+}
+
+TEST(parallel, deterministic_reduce) {
+    vector<double> v;
+    std::mt19937 gen(1);
+    for (int i = 0; i < 1000000; i++) {
+        v.push_back(std::generate_canonical<double, 53>(gen) * 1e6);
+    }
+
+    thread_pool one(1), three(3), eight(8);
+    double expected = parallel::reduce(v, 0.0, std::plus<double>(), true, one);
+    ASSERT_EQ(expected, parallel::reduce(v, 0.0, std::plus<double>(), true, three));
+    ASSERT_EQ(expected, parallel::reduce(v, 0.0, std::plus<double>(), true, eight));
+}
+
+TEST(parallel, nested_and_exceptions) {
+    thread_pool pool(3);
+    std::atomic<int> calls(0);
+    pool.parallel_for(8, [&](std::size_t) {
+        pool.parallel_for(8, [&](std::size_t) { calls++; });
+    });
+    ASSERT_EQ(64, calls.load());
+
+    ASSERT_THROW(pool.parallel_for(10, [](std::size_t i) {
+        if (i == 7) throw std::runtime_error("");
+    }), std::runtime_error);
+
+    // The rest still run when the caller is the only thread.
+    thread_pool single(1);
+    std::atomic<int> ran(0);
+    ASSERT_THROW(single.parallel_for(10, [&](std::size_t i) {
+        ran++;
+        if (i == 2) throw std::runtime_error("");
+    }), std::runtime_error);
+    ASSERT_EQ(10, ran.load());
+}
+
+TEST(concurrent_vector, producers_and_reader) {
+    concurrent_vector<std::string> v;
+    v.push_back("first");
+    const std::string *first = &v[0];
+
+    std::vector<std::thread> producers;
+    for (int t = 0; t < 4; t++) {
+        producers.emplace_back([&v, t] {
+            for (int i = 0; i < 10000; i++) {
+                std::size_t idx = v.emplace_back(std::to_string(t * 100000 + i));
+                ASSERT_TRUE(v.published(idx));
+            }
+        });
+    }
+
+    std::size_t seen = 0;
+    while (seen < 40001) {
+        seen = 0;
+        for (std::size_t i = 0; i < v.size(); i++) {
+            if (v.published(i)) {
+                ASSERT_FALSE(v[i].empty());
+                seen++;
+            }
+        }
+    }
+    for (auto &p : producers) {
+        p.join();
+    }
+
+    ASSERT_EQ(40001, v.size());
+    ASSERT_EQ(first, &v[0]);
+    ASSERT_EQ("first", v[0]);
+
+    std::vector<std::string> all;
+    for (std::size_t i = 1; i < v.size(); i++) {
+        all.push_back(v[i]);
+    }
+    std::sort(all.begin(), all.end());
+    ASSERT_TRUE(std::unique(all.begin(), all.end()) == all.end());
+}
+
+TEST(segmented_vector, matches_deque) {
+    segmented_vector<std::string> v;
+    std::deque<std::string> expected;
+    std::mt19937 gen(42);
+
+    for (int i = 0; i < 20000; i++) {
+        std::string item = std::to_string(i);
+        switch (gen() % 6) {
+            case 0:
+            case 1:
+                v.push_back(item);
+                expected.push_back(item);
+                break;
+            case 2:
+                v.push_front(item);
+                expected.push_front(item);
+                break;
+            case 3:
+                if (!v.empty()) {
+                    v.pop_back();
+                    expected.pop_back();
+                }
+                break;
+            case 4:
+                if (!v.empty()) {
+                    v.pop_front();
+                    expected.pop_front();
+                }
+                break;
+            case 5: {
+                std::size_t idx = gen() % (expected.size() + 1);
+                v.insert(v.begin() + idx, item);
+                expected.insert(expected.begin() + idx, item);
+                break;
+            }
+        }
+    }
+
+    ASSERT_EQ(expected.size(), v.size());
+    ASSERT_TRUE(std::equal(expected.begin(), expected.end(), v.begin()));
+    ASSERT_TRUE(std::equal(expected.rbegin(), expected.rend(), v.rbegin()));
+
+    v.erase(v.begin() + 10, v.begin() + 100);
+    expected.erase(expected.begin() + 10, expected.begin() + 100);
+    v.erase(v.end() - 100, v.end() - 10);
+    expected.erase(expected.end() - 100, expected.end() - 10);
+    ASSERT_TRUE(std::equal(expected.begin(), expected.end(), v.begin()));
+
+    segmented_vector<std::string> copy = v;
+    copy.shrink_to_fit();
+    ASSERT_TRUE(std::equal(expected.begin(), expected.end(), copy.begin()));
+}
+
+TEST(segmented_vector, sort_and_capacity) {
+    segmented_vector<int> v;
+    v.reserve(10000);
+    ASSERT_GE(v.capacity(), 10000);
+    for (int i = 0; i < 10000; i++) {
+        v.push_back((i * 7919) % 10000);
+    }
+    int *first = &v[0];
+    for (int i = 0; i < 10000; i++) {
+        v.push_front(i);
+        v.push_back(i);
+    }
+    ASSERT_EQ(first, &v[10000]);
+    v.erase(v.begin(), v.begin() + 10000);
+    v.resize(10000);
+    std::sort(v.begin(), v.end());
+    for (int i = 0; i < 10000; i++) {
+        ASSERT_EQ(i, v[i]);
+    }
+    ASSERT_EQ(first, &v[0]);
+
+    v.resize(10);
+    v.shrink_to_fit();
+    ASSERT_EQ(segmented_vector<int>::CHUNK, v.capacity());
+}
+
+TEST(segmented_vector, queue_keeps_table_small) {
+    const std::size_t chunk = segmented_vector<int>::CHUNK;
+    segmented_vector<int> forward, backward;
+    for (int i = 0; i < 100; i++) {
+        forward.push_back(i);
+        backward.push_front(i);
+    }
+    for (int i = 100; i < 100 * (int) chunk; i++) {
+        forward.push_back(i);
+        forward.pop_front();
+        backward.push_front(i);
+        backward.pop_back();
+        ASSERT_EQ(i - 99, forward.front());
+        ASSERT_EQ(i - 99, backward.back());
+    }
+    ASSERT_LE(forward.table_size(), 4);
+    ASSERT_LE(backward.table_size(), 4);
+    for (int i = 0; i < 100; i++) {
+        ASSERT_EQ(100 * (int) chunk - 100 + i, forward[i]);
+        ASSERT_EQ(100 * (int) chunk - 1 - i, backward[i]);
+    }
+}
+
+struct stats_test_site {
+    static const char *name() { return "stats_test"; }
+};
+
+TEST(vector_stats, counts_allocations_and_relocations) {
+    typedef vector<int, default_growth, counting_stats<stats_test_site>> counted;
+    auto &c = counting_stats<stats_test_site>::counters<int>();
+    {
+        counted v;
+        for (int i = 0; i < 1000; i++) {
+            v.push_back(i);
+        }
+        // 1, 2, 4, ..., 1024
+        ASSERT_EQ(11, c.allocations);
+        ASSERT_EQ(10, c.frees);
+        ASSERT_EQ(10, c.relocations);
+        ASSERT_EQ(1023, c.elements_relocated);
+        ASSERT_EQ(1023 * sizeof(int), c.bytes_relocated);
+        ASSERT_EQ(1024, c.peak_capacity);
+        ASSERT_EQ(1024 * sizeof(int), c.live_bytes);
+
+        counted copy(v);
+        ASSERT_EQ(12, c.allocations);
+        ASSERT_EQ((1024 + 1000) * sizeof(int), c.live_bytes);
+    }
+    ASSERT_EQ(12, c.frees);
+    ASSERT_EQ(0, c.live_bytes);
+    ASSERT_EQ(24 * sizeof(int), c.wasted_bytes);
+
+    std::ostringstream out;
+    vector_stats::dump(out);
+    ASSERT_NE(std::string::npos, out.str().find("int stats_test allocations=12 bytes_allocated=12188 frees=12"));
+
+    vector_stats::reset();
+    ASSERT_EQ(0, c.allocations);
+}
+
+struct stats_short_site {
+    static const char *name() { return "i"; }
+};
+
+struct stats_unnamed_site {};
+
+TEST(vector_stats, tags_as_given) {
+    vector<int, default_growth, counting_stats<stats_short_site>> named;
+    vector<int, default_growth, counting_stats<stats_unnamed_site>> unnamed;
+    named.push_back(1);
+    unnamed.push_back(1);
+
+    std::ostringstream out;
+    vector_stats::dump(out);
+    ASSERT_NE(std::string::npos, out.str().find("int i allocations=1 "));
+    ASSERT_NE(std::string::npos, out.str().find("int stats_unnamed_site allocations=1 "));
+}
+
+struct mapped_row {
+    std::int64_t id;
+    double value;
+    std::int32_t flags;
+};
+
+TEST(mapped_vector, save_and_map) {
+    std::string path = "/tmp/mapped_vector_test." + std::to_string(getpid());
+    vector<mapped_row> rows;
+    for (int i = 0; i < 100000; i++) {
+        rows.push_back(mapped_row{i, i * 0.5, i % 7});
+    }
+    save(rows, path.c_str());
+
+    mapped_vector<mapped_row> mapped(path.c_str());
+    ASSERT_EQ(rows.size(), mapped.size());
+    ASSERT_TRUE(mapped.verify());
+    ASSERT_EQ(0, (std::uintptr_t) mapped.data() % alignof(mapped_row));
+    for (std::size_t i = 0; i < rows.size(); i++) {
+        ASSERT_EQ(rows[i].id, mapped[i].id);
+        ASSERT_EQ(rows[i].value, mapped[i].value);
+        ASSERT_EQ(rows[i].flags, mapped[i].flags);
+    }
+    ASSERT_EQ(99999, mapped.rbegin()->id);
+
+    // Replacing the file leaves existing mappings intact.
+    save(rows.data(), 10, path.c_str());
+    mapped_vector<mapped_row> shorter(path.c_str());
+    ASSERT_EQ(10, shorter.size());
+    ASSERT_EQ(99999, mapped.back().id);
+    struct stat st;
+    ASSERT_EQ(0, stat(path.c_str(), &st));
+    ASSERT_EQ(0644, st.st_mode & 0777);
+    ASSERT_THROW(save(rows.data(), 10, "/nonexistent/mapped_vector"), std::system_error);
+
+    mapped = std::move(shorter);
+    ASSERT_EQ(10, mapped.size());
+    ASSERT_TRUE(shorter.empty());
+
+    ASSERT_THROW(mapped_vector<int>(path.c_str()), std::runtime_error);
+    ASSERT_THROW(mapped_vector<int>("/nonexistent/mapped_vector"), std::system_error);
+
+    {
+        FILE *f = fopen(path.c_str(), "r+b");
+        fseek(f, sizeof(mapped_header) + 3, SEEK_SET);
+        fputc(0x5a, f);
+        fclose(f);
+    }
+    ASSERT_FALSE(mapped_vector<mapped_row>(path.c_str()).verify());
+
+    vector<int> empty;
+    save(empty, path.c_str());
+    mapped_vector<int> none(path.c_str());
+    ASSERT_TRUE(none.empty());
+    ASSERT_EQ(none.begin(), none.end());
+    unlink(path.c_str());
+}
+
+TEST(soa_vector, columns_and_algorithms) {
+    soa_vector<int, float, std::string> v;
+    for (int i = 0; i < 1000; i++) {
+        v.push_back(std::make_tuple((i * 7919) % 1000, i * 0.5f, std::to_string(i)));
+    }
+    ASSERT_EQ(1000, v.size());
+    ASSERT_GE(v.capacity(), 1000);
+    ASSERT_EQ(v.column<0>().data() + 1, &v[1].get<0>());
+
+    auto ids = v.column<0>();
+    ASSERT_EQ(999 * 1000 / 2, simd::sum(ids.data(), ids.size()));
+    auto weights = v.column<1>();
+    ASSERT_NEAR(0.5f * 999 * 1000 / 2, simd::sum(weights.data(), weights.size()), 1.0f);
+
+    std::sort(v.begin(), v.end());
+    for (int i = 0; i < 1000; i++) {
+        ASSERT_EQ(i, v[i].get<0>());
+        ASSERT_EQ(std::to_string(std::stoi(v[i].get<2>())), v[i].get<2>());
+        ASSERT_EQ(std::stoi(v[i].get<2>()) * 0.5f, v[i].get<1>());
+    }
+
+    auto found = std::find_if(v.begin(), v.end(), [](soa_vector<int, float, std::string>::reference r) {
+        return r.get<2>() == "42";
+    });
+    ASSERT_EQ(42 * 7919 % 1000, (*found).get<0>());
+
+    std::tuple<int, float, std::string> last = v.back();
+    ASSERT_EQ(999, std::get<0>(last));
+    v.back() = std::make_tuple(-1, 0.0f, std::string("x"));
+    ASSERT_EQ("x", v[999].get<2>());
+    v.emplace_back(5, 1.0f, "five");
+    ASSERT_EQ("five", v.back().get<2>());
+    v.pop_back();
+
+    v.resize(10);
+    ASSERT_EQ(10, v.column<2>().size());
+    v.resize(20);
+    ASSERT_EQ(0, v[19].get<0>());
+    ASSERT_EQ("", v[19].get<2>());
+
+    soa_vector<int, float, std::string> other;
+    swap(v, other);
+    ASSERT_TRUE(v.empty());
+    ASSERT_EQ(20, other.size());
+    const auto &c = other;
+    int count = 0;
+    for (auto it = c.begin(); it != c.end(); ++it) {
+        count += (*it).get<0>() == 0;
+    }
+    ASSERT_EQ(11, count);
+}
@@ -0,0 +1,123 @@
+#include <exception>
+#include <utility>
+#include "thread_pool.h"
+
+// Queue owned by the current thread, if it is a worker of `current_pool`.
+static thread_local const thread_pool *current_pool = nullptr;
+static thread_local std::size_t current_queue = 0;
+
+thread_pool::thread_pool(std::size_t threads) : _queued(0), _next_queue(0), _stop(false) {
+    if (threads == 0) threads = 1;
+    for (std::size_t i = 0; i < threads; i++) {
+        _queues.emplace_back(new queue());
+    }
+    for (std::size_t i = 1; i < threads; i++) {
+        _workers.emplace_back(&thread_pool::work, this, i);
+    }
+}
+
+thread_pool::~thread_pool() {
+    {
+        std::lock_guard<std::mutex> guard(_sleep_lock);
+        _stop = true;
+    }
+    _wake.notify_all();
+    for (auto &worker : _workers) {
+        worker.join();
+    }
+}
+
+std::size_t thread_pool::size() const {
+    return _queues.size();
+}
+
+thread_pool &thread_pool::global() {
+    static thread_pool pool;
+    return pool;
+}
+
+void thread_pool::push(std::function<void()> task) {
+    std::size_t idx = current_pool == this ? current_queue : _next_queue++ % _queues.size();
+    {
+        std::lock_guard<std::mutex> guard(_queues[idx]->lock);
+        _queues[idx]->tasks.push_back(std::move(task));
+    }
+    _queued++;
+    {
+        std::lock_guard<std::mutex> guard(_sleep_lock);
+    }
+    _wake.notify_one();
+}
+
+bool thread_pool::try_run_one() {
+    std::size_t own = current_pool == this ? current_queue : 0;
+    std::function<void()> task;
+    for (std::size_t i = 0; i < _queues.size() && !task; i++) {
+        auto &q = *_queues[(own + i) % _queues.size()];
+        std::lock_guard<std::mutex> guard(q.lock);
+        if (q.tasks.empty()) continue;
+        if (i == 0) {
+            task = std::move(q.tasks.back());
+            q.tasks.pop_back();
+        } else {
+            task = std::move(q.tasks.front());
+            q.tasks.pop_front();
+        }
+    }
+    if (!task) return false;
+
+    _queued--;
+    task();
+    return true;
+}
+
+void thread_pool::work(std::size_t idx) {
+    current_pool = this;
+    current_queue = idx;
+    while (true) {
+        if (try_run_one()) continue;
+
+        std::unique_lock<std::mutex> lock(_sleep_lock);
+        _wake.wait(lock, [this] { return _stop || _queued.load() > 0; });
+        if (_stop) return;
+    }
+}
+
+void thread_pool::parallel_for(std::size_t n, const std::function<void(std::size_t)> &f) {
+    if (n == 0) return;
+    if (n == 1 || size() == 1) {
+        std::exception_ptr error;
+        for (std::size_t i = 0; i < n; i++) {
+            try {
+                f(i);
+            } catch (...) {
+                if (!error) error = std::current_exception();
+            }
+        }
+        if (error) std::rethrow_exception(error);
+        return;
+    }
+
+    std::atomic<std::size_t> pending(n);
+    std::exception_ptr error;
+    std::mutex error_lock;
+    auto run = [&](std::size_t i) {
+        try {
+            f(i);
+        } catch (...) {
+            std::lock_guard<std::mutex> guard(error_lock);
+            if (!error) error = std::current_exception();
+        }
+        pending.fetch_sub(1, std::memory_order_release);
+    };
+
+    for (std::size_t i = n - 1; i > 0; i--) {
+        push([&run, i] { run(i); });
+    }
+    run(0);
+    while (pending.load(std::memory_order_acquire) != 0) {
+        if (!try_run_one()) std::this_thread::yield();
+    }
+
+    if (error) std::rethrow_exception(error);
+}
@@ -0,0 +1,58 @@
+#ifndef VECTOR_THREAD_POOL_H
+#define VECTOR_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing pool. Every worker owns a deque: it pops its own tasks from the back and,
+// when that runs dry, steals from the front of the others. Threads waiting in
+// parallel_for run queued tasks meanwhile, so parallel_for may be nested inside tasks.
+struct thread_pool {
+public:
+    // Starts `threads - 1` workers; the thread calling parallel_for is the last one.
+    explicit thread_pool(std::size_t threads = std::thread::hardware_concurrency());
+
+    thread_pool(const thread_pool &) = delete;
+
+    thread_pool &operator=(const thread_pool &) = delete;
+
+    ~thread_pool();
+
+    // Threads that run tasks, including the caller of parallel_for.
+    std::size_t size() const;
+
+    // Calls f(0), ..., f(n - 1) on the pool and returns once all of them are done.
+    // The first exception thrown by f is rethrown here after the rest have finished.
+    void parallel_for(std::size_t n, const std::function<void(std::size_t)> &f);
+
+    static thread_pool &global();
+
+private:
+    struct queue {
+        std::mutex lock;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<queue>> _queues;
+    std::vector<std::thread> _workers;
+    std::atomic<std::size_t> _queued;
+    std::atomic<std::size_t> _next_queue;
+    std::mutex _sleep_lock;
+    std::condition_variable _wake;
+    bool _stop;
+
+    void push(std::function<void()> task);
+
+    bool try_run_one();
+
+    void work(std::size_t idx);
+};
+
+#endif //VECTOR_THREAD_POOL_H
@@ -1,306 +1,497 @@
-#include <cstdlib>
-#include <new>
 #include <cassert>
 #include <iterator>
+#include <type_traits>
+#include <utility>
+#include <algorithm>
+#include <cstring>
+#include <memory>
 #include "vector.h"
+#include "memory_resource.h"
+#include "storage.h"
+
+template<typename T, typename Growth, typename Stats>
+T *vector<T, Growth, Stats>::alloc_storage(std::size_t capacity) {
+    if (capacity == 0) return nullptr;
+    T *storage = _resource ? (T *) _resource->allocate(capacity * sizeof(T), alignof(T)) : smart_alloc<T>(capacity);
+    Stats::template allocated<T>(capacity);
+    return storage;
+}
+
+template<typename T, typename Growth, typename Stats>
+void vector<T, Growth, Stats>::free_storage(T *storage, std::size_t used, std::size_t capacity) {
+    if (!storage) return;
+    Stats::template freed<T>(used, capacity);
+    if (!_resource) {
+        smart_free(storage, capacity);
+    } else {
+        _resource->deallocate(storage, capacity * sizeof(T), alignof(T));
+    }
+}
 
-template<typename T>
-typename std::enable_if<std::is_trivially_copyable<T>::value>::type smart_copy(T *from, T *to, std::size_t cnt) {
-    memcpy(to, from, cnt * sizeof(T));
+template<typename T, typename Growth, typename Stats>
+vector<T, Growth, Stats>::vector() noexcept {
+    _size = _capacity = _written = 0;
+    _storage = nullptr;
+    _resource = nullptr;
 }
 
-template<typename T>
-typename std::enable_if<!std::is_trivially_copyable<T>::value>::type smart_copy(T *from, T *to, std::size_t cnt) {
-    for (std::size_t i = 0; i < cnt; i++) {
-        to[i] = T(from[i]);
-    }
+template<typename T, typename Growth, typename Stats>
+vector<T, Growth, Stats>::vector(std::pmr::memory_resource *resource) noexcept : vector<T, Growth, Stats>() {
+    _resource = resource;
 }
 
-template<typename T>
-typename std::enable_if<std::is_trivially_destructible<T>::value>::type smart_delete(T *ptr, std::size_t cnt) {
-    operator delete(ptr);
+template<typename T, typename Growth, typename Stats>
+vector<T, Growth, Stats>::vector(std::size_t initial_size) : vector<T, Growth, Stats>() {
+    resize(initial_size);
 }
 
-template<typename T>
-typename std::enable_if<!std::is_trivially_destructible<T>::value>::type smart_delete(T *ptr, std::size_t cnt) {
-    for (std::size_t i = 0; i < cnt; i++) {
-        ptr[i].~T();
+template<typename T, typename Growth, typename Stats>
+vector<T, Growth, Stats>::vector(const vector<T, Growth, Stats> &other) : vector<T, Growth, Stats>(other, nullptr) {}
+
+template<typename T, typename Growth, typename Stats>
+vector<T, Growth, Stats>::vector(const vector<T, Growth, Stats> &other, std::pmr::memory_resource *resource) {
+    _size = _capacity = _written = other._size;
+    _resource = resource;
+    _storage = alloc_storage(_capacity);
+    try {
+        smart_copy(other._storage, _storage, _size);
+    } catch (...) {
+        free_storage(_storage, 0, _capacity);
+        throw;
     }
-    operator delete(ptr);
 }
 
-template<typename T>
-T *vector<T>::alloc_storage(std::size_t capacity) {
-    return (T *) operator new(sizeof(T) * capacity);
-}
+template<typename T, typename Growth, typename Stats>
+vector<T, Growth, Stats>::vector(vector<T, Growth, Stats> &&other) noexcept {
+    _size = other._size;
+    _capacity = other._capacity;
+    _storage = other._storage;
+    _resource = other._resource;
+    _written = other._written;
+
+    other._size = other._capacity = other._written = 0;
+    other._storage = nullptr;
+}
+
+template<typename T, typename Growth, typename Stats>
+void vector<T, Growth, Stats>::relocate(std::size_t new_capacity) {
+    assert(new_capacity >= _size);
+
+    if (!_resource) {
+        if (_size > 0) Stats::template relocated<T>(_size);
+        if (new_capacity > 0) Stats::template allocated<T>(new_capacity);
+        if (_storage) Stats::template freed<T>(_size, _capacity);
+        bool was_mapped = smart_is_mapped<T>(_capacity);
+        _storage = smart_relocate(_storage, _size, _capacity, new_capacity);
+        // Remapping keeps the written pages; any other move copies only the elements.
+        if (!was_mapped || !smart_is_mapped<T>(new_capacity)) _written = _size;
+        _capacity = new_capacity;
+        return;
+    }
 
-template<typename T>
-vector<T>::vector() noexcept {
-    _size = _capacity = 0;
-    _storage = nullptr;
-}
+    auto *resizable = dynamic_cast<resizable_resource *>(_resource);
+    if (resizable && _storage && new_capacity > 0 &&
+        resizable->resize(_storage, _capacity * sizeof(T), new_capacity * sizeof(T), alignof(T))) {
+        Stats::template allocated<T>(new_capacity);
+        Stats::template freed<T>(_size, _capacity);
+        _capacity = new_capacity;
+        return;
+    }
 
-template<typename T>
-vector<T>::vector(std::size_t initial_size) {
-    _size = _capacity = initial_size;
-    _storage = alloc_storage(initial_size);
-    std::size_t i;
+    if (_size > 0) Stats::template relocated<T>(_size);
+    T *new_storage = alloc_storage(new_capacity);
     try {
-        for (i = 0; i < initial_size; i++) {
-            new(&_storage[i]) T();
-        }
+        smart_move(_storage, new_storage, _size);
     } catch (...) {
-        for (std::size_t j = 0; j < i; j++) {
-            _storage[j].~T();
-        }
+        free_storage(new_storage, 0, new_capacity);
         throw;
     }
-}
+    smart_destroy(_storage, _size);
+    free_storage(_storage, _size, _capacity);
 
-template<typename T>
-vector<T>::vector(const vector<T> &other) {
-    _size = _capacity = other._size;
-    _storage = alloc_storage(_capacity);
-    smart_copy(other._storage, _storage, _size);
+    _storage = new_storage;
+    _capacity = new_capacity;
+    _written = _size;
 }
 
-template<typename T>
-void vector<T>::increase_capacity() {
+template<typename T, typename Growth, typename Stats>
+void vector<T, Growth, Stats>::increase_capacity() {
     assert(_size == _capacity);
-    if (_capacity == 0) reserve(1);
-    else reserve(_capacity * 2);
+    reserve(Growth::grow(_capacity));
 }
 
-template<typename T>
-void vector<T>::decrease_capacity() {
-    assert(_size * 2 <= _capacity);
-    if (_capacity == 1) return;
+template<typename T, typename Growth, typename Stats>
+void vector<T, Growth, Stats>::decrease_capacity() {
+    assert(Growth::should_shrink(_size, _capacity));
 
-    auto *new_storage = alloc_storage(_capacity / 2);
-    smart_copy(_storage, new_storage, _size);
-    smart_delete(_storage, _capacity);
+    relocate(Growth::shrink(_capacity));
+}
 
-    _storage = new_storage;
-    _capacity /= 2;
+template<typename T, typename Growth, typename Stats>
+void vector<T, Growth, Stats>::push_back(const T &item) {
+    emplace_back(item);
+}
+
+template<typename T, typename Growth, typename Stats>
+void vector<T, Growth, Stats>::push_back(T &&item) {
+    emplace_back(std::move(item));
 }
 
-template<typename T>
-void vector<T>::push_back(const T &item) {
+template<typename T, typename Growth, typename Stats>
+template<typename... Args>
+T &vector<T, Growth, Stats>::emplace_back(Args &&... args) {
     if (_size == _capacity) {
+        // args may refer to an element of this vector, so build the value before relocating
+        T item(std::forward<Args>(args)...);
         increase_capacity();
+        new(&_storage[_size]) T(std::move(item));
+    } else {
+        new(&_storage[_size]) T(std::forward<Args>(args)...);
     }
-    new(&_storage[_size]) T(item);
-    _size++;
+    return _storage[_size++];
 }
 
-template<typename T>
-void vector<T>::pop_back() {
+template<typename T, typename Growth, typename Stats>
+void vector<T, Growth, Stats>::pop_back() {
+    _written = std::max(_written, _size);
     _storage[--_size].~T();
 
-    if (_size * 2 <= _capacity) decrease_capacity();
+    if (Growth::should_shrink(_size, _capacity)) decrease_capacity();
 }
 
-template<typename T>
-std::size_t vector<T>::size() const {
+template<typename T, typename Growth, typename Stats>
+std::size_t vector<T, Growth, Stats>::size() const {
     return _size;
 }
 
-template<typename T>
-bool vector<T>::empty() const {
+template<typename T, typename Growth, typename Stats>
+bool vector<T, Growth, Stats>::empty() const {
     return _size == 0;
 }
 
-template<typename T>
-std::size_t vector<T>::capacity() const {
+template<typename T, typename Growth, typename Stats>
+std::size_t vector<T, Growth, Stats>::capacity() const {
     return _capacity;
 }
 
-template<typename T>
-void vector<T>::shrink_to_fit() {
-    auto *new_storage = alloc_storage(_size);
-    smart_copy(_storage, new_storage, _size);
-    _storage = new_storage;
-    _capacity = _size;
+template<typename T, typename Growth, typename Stats>
+std::pmr::memory_resource *vector<T, Growth, Stats>::resource() const {
+    return _resource;
+}
+
+template<typename T, typename Growth, typename Stats>
+void vector<T, Growth, Stats>::shrink_to_fit() {
+    if (_size == _capacity) return;
+    relocate(_size);
 }
 
-template<typename T>
-T *vector<T>::data() {
+template<typename T, typename Growth, typename Stats>
+T *vector<T, Growth, Stats>::data() {
     return _storage;
 }
 
-template<typename T>
-const T *vector<T>::data() const {
+template<typename T, typename Growth, typename Stats>
+const T *vector<T, Growth, Stats>::data() const {
     return _storage;
 }
 
-template<typename T>
-T &vector<T>::back() {
+template<typename T, typename Growth, typename Stats>
+T &vector<T, Growth, Stats>::back() {
     assert(_size > 0);
     return _storage[_size - 1];
 }
 
-template<typename T>
-const T &vector<T>::back() const {
+template<typename T, typename Growth, typename Stats>
+const T &vector<T, Growth, Stats>::back() const {
     assert(_size > 0);
     return _storage[_size - 1];
 }
 
-template<typename T>
-T &vector<T>::operator[](std::size_t idx) {
+template<typename T, typename Growth, typename Stats>
+T &vector<T, Growth, Stats>::operator[](std::size_t idx) {
     assert(idx < _size);
     return _storage[idx];
 }
 
-template<typename T>
-const T &vector<T>::operator[](std::size_t idx) const {
+template<typename T, typename Growth, typename Stats>
+const T &vector<T, Growth, Stats>::operator[](std::size_t idx) const {
     assert(idx < _size);
     return _storage[idx];
 }
 
-template<typename T>
-void vector<T>::reserve(std::size_t new_capacity) {
+template<typename T, typename Growth, typename Stats>
+void vector<T, Growth, Stats>::reserve(std::size_t new_capacity) {
     if (new_capacity <= _capacity) return;
 
-    auto *new_storage = (T *) operator new(new_capacity * sizeof(T));
-    smart_copy(_storage, new_storage, _size);
-    smart_delete(_storage, _size);
+    relocate(new_capacity);
+}
 
-    _storage = new_storage;
-    _capacity = new_capacity;
+template<typename T, typename Growth, typename Stats>
+void vector<T, Growth, Stats>::truncate(std::size_t new_size) {
+    assert(new_size <= _size);
+    if (new_size == _size) return;
+    smart_destroy(_storage + new_size, _size - new_size);
+    _written = std::max(_written, _size);
+    _size = new_size;
+    if (!_resource && smart_is_mapped<T>(_capacity)) {
+        // The pages past the last element are dropped and read as zeros again.
+        smart_release_tail(_storage, _size, _capacity);
+        _written = std::min(_written, (page_round(_size * sizeof(T)) + sizeof(T) - 1) / sizeof(T));
+    }
 }
 
-template<typename T>
-void vector<T>::resize(std::size_t new_size, T value) {
+template<typename T, typename Growth, typename Stats>
+void vector<T, Growth, Stats>::resize(std::size_t new_size) {
+    if (new_size <= _size) {
+        truncate(new_size);
+        return;
+    }
+
     reserve(new_size);
 
-    for (std::size_t i = _size; i < new_size; i++) {
-        _storage[i] = value;
+    if constexpr (std::is_trivially_default_constructible<T>::value) {
+        std::size_t dirty_end = new_size;
+        if (!_resource && smart_is_mapped<T>(_capacity)) dirty_end = std::min(new_size, _written);
+        if (dirty_end > _size) memset((void *) (_storage + _size), 0, (dirty_end - _size) * sizeof(T));
+        _size = new_size;
+    } else {
+        std::size_t old_size = _size;
+        try {
+            for (; _size < new_size; _size++) {
+                new(&_storage[_size]) T();
+            }
+        } catch (...) {
+            smart_destroy(_storage + old_size, _size - old_size);
+            _size = old_size;
+            throw;
+        }
     }
-    _size = new_size;
 }
 
-template<typename T>
-void vector<T>::clear() {
-    operator delete(_storage);
+template<typename T, typename Growth, typename Stats>
+void vector<T, Growth, Stats>::resize(std::size_t new_size, T value) {
+    if (new_size <= _size) {
+        truncate(new_size);
+        return;
+    }
+
+    reserve(new_size);
 
-    _storage = (T *) operator new(0);
-    _size = _capacity = 0;
+    for (; _size < new_size; _size++) {
+        new(&_storage[_size]) T(value);
+    }
 }
 
-template<typename T>
-typename vector<T>::iterator vector<T>::begin() {
+template<typename T, typename Growth, typename Stats>
+void vector<T, Growth, Stats>::clear() {
+    smart_destroy(_storage, _size);
+    free_storage(_storage, _size, _capacity);
+
+    _storage = nullptr;
+    _size = _capacity = _written = 0;
+}
+
+template<typename T, typename Growth, typename Stats>
+typename vector<T, Growth, Stats>::iterator vector<T, Growth, Stats>::begin() {
     return empty() ? nullptr : _storage;
 }
 
-template<typename T>
-typename vector<T>::iterator vector<T>::end() {
+template<typename T, typename Growth, typename Stats>
+typename vector<T, Growth, Stats>::iterator vector<T, Growth, Stats>::end() {
     return empty() ? nullptr : (_storage + _size);
 }
 
-template<typename T>
-typename vector<T>::const_iterator vector<T>::begin() const {
+template<typename T, typename Growth, typename Stats>
+typename vector<T, Growth, Stats>::const_iterator vector<T, Growth, Stats>::begin() const {
     return empty() ? nullptr : _storage;
 }
 
-template<typename T>
-typename vector<T>::const_iterator vector<T>::end() const {
+template<typename T, typename Growth, typename Stats>
+typename vector<T, Growth, Stats>::const_iterator vector<T, Growth, Stats>::end() const {
     return empty() ? nullptr : (_storage + _size);
 }
 
-template<typename T>
-vector<T> &vector<T>::operator=(const vector<T> &other) {
-    _size = _capacity = other._size;
-    _storage = alloc_storage(_size);
-    smart_copy(other._storage, _storage, _size);
+template<typename T, typename Growth, typename Stats>
+vector<T, Growth, Stats> &vector<T, Growth, Stats>::operator=(const vector<T, Growth, Stats> &other) {
+    vector<T, Growth, Stats> tmp(other, _resource);
+    swap(tmp);
+    return *this;
+}
+
+template<typename T, typename Growth, typename Stats>
+vector<T, Growth, Stats> &vector<T, Growth, Stats>::operator=(vector<T, Growth, Stats> &&other) noexcept {
+    vector<T, Growth, Stats> tmp(std::move(other));
+    swap(tmp);
     return *this;
 }
 
-template<typename T>
-typename vector<T>::reverse_iterator vector<T>::rbegin() {
+template<typename T, typename Growth, typename Stats>
+typename vector<T, Growth, Stats>::reverse_iterator vector<T, Growth, Stats>::rbegin() {
     return reverse_iterator(end());
 }
 
-template<typename T>
-typename vector<T>::reverse_iterator vector<T>::rend() {
+template<typename T, typename Growth, typename Stats>
+typename vector<T, Growth, Stats>::reverse_iterator vector<T, Growth, Stats>::rend() {
     return reverse_iterator(begin());
 }
 
-template<typename T>
-typename vector<T>::const_reverse_iterator vector<T>::rbegin() const {
+template<typename T, typename Growth, typename Stats>
+typename vector<T, Growth, Stats>::const_reverse_iterator vector<T, Growth, Stats>::rbegin() const {
     return const_reverse_iterator(end());
 }
 
-template<typename T>
-typename vector<T>::const_reverse_iterator vector<T>::rend() const {
+template<typename T, typename Growth, typename Stats>
+typename vector<T, Growth, Stats>::const_reverse_iterator vector<T, Growth, Stats>::rend() const {
     return const_reverse_iterator(begin());
 }
 
-template<typename T>
+template<typename T, typename Growth, typename Stats>
 template<typename Iterator>
-vector<T>::vector(Iterator first, Iterator last) : vector<T>() {
-    for (; first != last; first++) {
-        push_back(*first);
-    }
+vector<T, Growth, Stats>::vector(Iterator first, Iterator last) : vector<T, Growth, Stats>() {
+    append(first, last);
 }
 
-template<typename T>
+template<typename T, typename Growth, typename Stats>
 template<typename Iterator>
-void vector<T>::assign(Iterator first, Iterator last) {
-    clear();
-    for (; first != last; first++) {
-        push_back(*first);
-    }
+void vector<T, Growth, Stats>::assign(Iterator first, Iterator last) {
+    smart_destroy(_storage, _size);
+    _written = std::max(_written, _size);
+    _size = 0;
+    append(first, last);
 }
 
-template<typename T>
-typename vector<T>::iterator vector<T>::insert(vector::const_iterator pos, const T &value) {
+template<typename T, typename Growth, typename Stats>
+template<typename Iterator>
+typename vector<T, Growth, Stats>::iterator vector<T, Growth, Stats>::insert(vector::const_iterator pos, Iterator first, Iterator last) {
     std::size_t idx = pos - begin();
+    insert_range(idx, first, last, typename std::iterator_traits<Iterator>::iterator_category());
+    return begin() + idx;
+}
 
-    if (_size == _capacity) increase_capacity();
+template<typename T, typename Growth, typename Stats>
+template<typename Iterator>
+void vector<T, Growth, Stats>::append(Iterator first, Iterator last) {
+    insert_range(_size, first, last, typename std::iterator_traits<Iterator>::iterator_category());
+}
+
+template<typename T, typename Growth, typename Stats>
+template<typename Iterator>
+void vector<T, Growth, Stats>::insert_range(std::size_t idx, Iterator first, Iterator last, std::forward_iterator_tag) {
+    insert_n(idx, first, (std::size_t) std::distance(first, last));
+}
 
-    for (auto i = _size; i > idx; i--) {
-        _storage[i] = _storage[i - 1];
+// The length of an input range is unknown up front: append it, then rotate it into place.
+template<typename T, typename Growth, typename Stats>
+template<typename Iterator>
+void vector<T, Growth, Stats>::insert_range(std::size_t idx, Iterator first, Iterator last, std::input_iterator_tag) {
+    std::size_t old_size = _size;
+    for (; first != last; ++first) {
+        emplace_back(*first);
     }
-    _size++;
-    _storage[idx] = value;
+    std::rotate(_storage + idx, _storage + old_size, _storage + _size);
+}
 
-    return begin() + idx;
+template<typename T, typename Growth, typename Stats>
+template<typename Iterator>
+void vector<T, Growth, Stats>::insert_n(std::size_t idx, Iterator first, std::size_t cnt) {
+    assert(idx <= _size);
+    if (cnt == 0) return;
+
+    if (_size + cnt > _capacity) {
+        std::size_t new_capacity = std::max(Growth::grow(_capacity), _size + cnt);
+        T *new_storage = alloc_storage(new_capacity);
+        try {
+            smart_insert_into(_storage, _size, idx, first, cnt, new_storage);
+        } catch (...) {
+            free_storage(new_storage, 0, new_capacity);
+            throw;
+        }
+        if (_size > 0) Stats::template relocated<T>(_size);
+        smart_destroy(_storage, _size);
+        free_storage(_storage, _size, _capacity);
+
+        _storage = new_storage;
+        _capacity = new_capacity;
+        _written = 0;
+    } else {
+        smart_insert_n(_storage, _size, idx, first, cnt);
+    }
+    _size += cnt;
 }
 
-template<typename T>
-void swap(vector<T> &a, vector<T> &b) {
-    swap(a._storage, b._storage);
-    swap(a._size, b._size);
-    swap(a._capacity, b._capacity);
+template<typename T, typename Growth, typename Stats>
+template<typename Predicate>
+std::size_t vector<T, Growth, Stats>::erase_if(Predicate pred) {
+    std::size_t old_size = _size;
+    _written = std::max(_written, _size);
+    _size = smart_erase_if(_storage, _size, pred);
+    return old_size - _size;
 }
 
-template<typename T>
-typename vector<T>::iterator vector<T>::erase(vector::const_iterator pos) {
+template<typename T, typename Growth, typename Stats>
+typename vector<T, Growth, Stats>::iterator vector<T, Growth, Stats>::swap_erase(vector::const_iterator pos) {
     std::size_t idx = pos - begin();
+    assert(idx < _size);
+
+    _written = std::max(_written, _size);
+    _size = smart_swap_erase(_storage, _size, idx);
+
+    return begin() + idx;
+}
+
+template<typename T, typename Growth, typename Stats>
+typename vector<T, Growth, Stats>::iterator vector<T, Growth, Stats>::insert(vector::const_iterator pos, const T &value) {
+    return emplace(pos, value);
+}
 
-    for (auto i = idx; i < _size - 1; i++) {
-        _storage[i] = _storage[i + 1];
+template<typename T, typename Growth, typename Stats>
+typename vector<T, Growth, Stats>::iterator vector<T, Growth, Stats>::insert(vector::const_iterator pos, T &&value) {
+    return emplace(pos, std::move(value));
+}
+
+template<typename T, typename Growth, typename Stats>
+template<typename... Args>
+typename vector<T, Growth, Stats>::iterator vector<T, Growth, Stats>::emplace(vector::const_iterator pos, Args &&... args) {
+    std::size_t idx = pos - begin();
+    if (idx == _size) {
+        emplace_back(std::forward<Args>(args)...);
+        return begin() + idx;
     }
-    _size--;
+
+    T item(std::forward<Args>(args)...);
+    if (_size == _capacity) increase_capacity();
+    smart_emplace_at(_storage, _size, idx, item);
 
     return begin() + idx;
 }
 
-template<typename T>
-typename vector<T>::iterator vector<T>::erase(vector::const_iterator from, vector::const_iterator to) {
+template<typename T, typename Growth, typename Stats>
+void vector<T, Growth, Stats>::swap(vector<T, Growth, Stats> &other) noexcept {
+    std::swap(_storage, other._storage);
+    std::swap(_size, other._size);
+    std::swap(_capacity, other._capacity);
+    std::swap(_resource, other._resource);
+    std::swap(_written, other._written);
+}
+
+template<typename T, typename Growth, typename Stats>
+typename vector<T, Growth, Stats>::iterator vector<T, Growth, Stats>::erase(vector::const_iterator pos) {
+    return erase(pos, pos + 1);
+}
+
+template<typename T, typename Growth, typename Stats>
+typename vector<T, Growth, Stats>::iterator vector<T, Growth, Stats>::erase(vector::const_iterator from, vector::const_iterator to) {
     std::size_t from_idx = from - begin();
     std::size_t to_idx = to - begin();
 
-    std::size_t diff = to_idx - from_idx;
-    for (std::size_t i = from_idx; i < _size - diff; i++) {
-        _storage[i] = _storage[i + diff];
-    }
-    _size -= diff;
+    _written = std::max(_written, _size);
+    _size = smart_erase(_storage, _size, from_idx, to_idx);
 
     return begin() + from_idx;
 }
 
-template<typename T>
-vector<T>::~vector() {
-    smart_delete(_storage, _capacity);
+template<typename T, typename Growth, typename Stats>
+vector<T, Growth, Stats>::~vector() {
+    smart_destroy(_storage, _size);
+    free_storage(_storage, _size, _capacity);
 }
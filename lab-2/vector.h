@@ -2,20 +2,78 @@
 #define VECTOR_VECTOR_H
 
 #include <cstddef>
+#include <iterator>
+#include <memory_resource>
+
+// Growth policy: a full buffer grows to capacity * Num / Den, and once no more than
+// capacity / ShrinkDivisor elements are left it is halved. The gap between the two
+// thresholds keeps a vector hovering around one size from reallocating on every
+// push/pop pair. ShrinkDivisor == 0 never shrinks implicitly.
+template<std::size_t Num, std::size_t Den, std::size_t ShrinkDivisor>
+struct geometric_growth {
+    static_assert(Num > Den, "growth factor must be greater than 1");
+    static_assert(ShrinkDivisor == 0 || ShrinkDivisor > 2, "shrinking to half must leave room to grow");
+
+    static std::size_t grow(std::size_t capacity) {
+        std::size_t next = capacity / Den * Num + capacity % Den * Num / Den;
+        return next > capacity ? next : capacity + 1;
+    }
+
+    static bool should_shrink(std::size_t size, std::size_t capacity) {
+        return ShrinkDivisor != 0 && capacity > 1 && size * ShrinkDivisor <= capacity;
+    }
+
+    static std::size_t shrink(std::size_t capacity) {
+        return capacity / 2;
+    }
+};
+
+typedef geometric_growth<2, 1, 4> default_growth;
+
+template<std::size_t Num = 2, std::size_t Den = 1>
+using no_shrink_growth = geometric_growth<Num, Den, 0>;
+
+// Instrumentation policy that records nothing; every hook compiles away.
+// See counting_stats in vector_stats.h for the counting one.
+struct no_stats {
+    template<typename T>
+    static void allocated(std::size_t) {}
+
+    template<typename T>
+    static void freed(std::size_t, std::size_t) {}
 
-template<typename T>
+    template<typename T>
+    static void relocated(std::size_t) {}
+};
+
+template<typename T, typename Growth = default_growth, typename Stats = no_stats>
 struct vector {
 public:
     vector() noexcept;
 
+    // Takes all storage from `resource` instead of the global heap. Moves and swaps carry the
+    // resource along with the buffer; copies use the global heap unless given a resource.
+    explicit vector(std::pmr::memory_resource *resource) noexcept;
+
     explicit vector(std::size_t initial_size);
 
-    vector(const vector<T> &other);
+    vector(const vector &other);
+
+    vector(const vector &other, std::pmr::memory_resource *resource);
 
-    vector &operator=(const vector<T> &other);
+    vector(vector &&other) noexcept;
+
+    vector &operator=(const vector &other);
+
+    vector &operator=(vector &&other) noexcept;
 
     void push_back(const T &item);
 
+    void push_back(T &&item);
+
+    template<typename... Args>
+    T &emplace_back(Args &&... args);
+
     void pop_back();
 
     T &back();
@@ -38,14 +96,22 @@ public:
 
     std::size_t capacity() const;
 
+    std::pmr::memory_resource *resource() const;
+
     void shrink_to_fit();
 
     void clear();
 
-    void resize(std::size_t new_size, T value = T());
+    // Value-initializes new elements. For trivial T, pages the buffer grows into are
+    // left to the kernel's zero pages instead of being written.
+    void resize(std::size_t new_size);
+
+    void resize(std::size_t new_size, T value);
 
     ~vector();
 
+    typedef T value_type;
+
     // Iterators:
 
     typedef T *iterator;
@@ -71,27 +137,71 @@ public:
 
     iterator insert(const_iterator pos, const T &value);
 
+    iterator insert(const_iterator pos, T &&value);
+
+    template<typename... Args>
+    iterator emplace(const_iterator pos, Args &&... args);
+
     iterator erase(const_iterator pos);
 
     iterator erase(const_iterator from, const_iterator to);
 
+    // Inserts [first, last) before pos, growing the buffer at most once and moving the tail once.
+    // The range must not point into this vector.
+    template<typename Iterator>
+    iterator insert(const_iterator pos, Iterator first, Iterator last);
+
+    template<typename Iterator>
+    void append(Iterator first, Iterator last);
+
+    // Removes every element matching pred in a single pass and returns how many were removed.
+    template<typename Predicate>
+    std::size_t erase_if(Predicate pred);
+
+    // Removes the element at pos by moving the last element into its place. Doesn't keep the order.
+    iterator swap_erase(const_iterator pos);
+
     template<typename Iterator>
     vector(Iterator first, Iterator last);
 
     template<typename Iterator>
     void assign(Iterator first, Iterator last);
 
-    friend void swap(vector<T> &a, vector<T> &b);
+    void swap(vector &other) noexcept;
+
+    friend void swap(vector &a, vector &b) noexcept {
+        a.swap(b);
+    }
 
 private:
     std::size_t _size;
     std::size_t _capacity;
     T *_storage;
+    std::pmr::memory_resource *_resource;
+    // In a mapped buffer, the elements from max(_size, _written) on have not been written since
+    // their pages were mapped, so they still read as zeros and resize() needn't clear them.
+    std::size_t _written;
 
     void increase_capacity();
     void decrease_capacity();
 
+    void relocate(std::size_t new_capacity);
+
+    void truncate(std::size_t new_size);
+
+    template<typename Iterator>
+    void insert_n(std::size_t idx, Iterator first, std::size_t cnt);
+
+    template<typename Iterator>
+    void insert_range(std::size_t idx, Iterator first, Iterator last, std::forward_iterator_tag);
+
+    template<typename Iterator>
+    void insert_range(std::size_t idx, Iterator first, Iterator last, std::input_iterator_tag);
+
     T *alloc_storage(std::size_t capacity);
+
+    // `used` is how many elements the buffer held, for the wasted capacity statistics.
+    void free_storage(T *storage, std::size_t used, std::size_t capacity);
 };
 
 #endif //VECTOR_VECTOR_H
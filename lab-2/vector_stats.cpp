@@ -0,0 +1,87 @@
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include "vector_stats.h"
+
+#ifdef __GNUG__
+#include <cxxabi.h>
+#endif
+
+namespace vector_stats {
+    struct registered {
+        std::string type;
+        std::string tag;
+        std::size_t element_size;
+        std::unique_ptr<vector_counters> counters;
+    };
+
+    std::mutex &registry_lock() {
+        static std::mutex lock;
+        return lock;
+    }
+
+    std::vector<registered> &registry() {
+        static std::vector<registered> entries;
+        return entries;
+    }
+
+    std::string demangle(const char *name) {
+#ifdef __GNUG__
+        int status = 0;
+        char *readable = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+        if (status == 0 && readable) {
+            std::string result(readable);
+            free(readable);
+            return result;
+        }
+#endif
+        return name;
+    }
+
+    vector_counters &register_counters(const std::type_info &type, const char *tag, std::size_t element_size) {
+        std::lock_guard<std::mutex> guard(registry_lock());
+        registry().push_back(registered{demangle(type.name()), tag, element_size,
+                                        std::unique_ptr<vector_counters>(new vector_counters())});
+        return *registry().back().counters;
+    }
+
+    std::vector<vector_stats_entry> snapshot() {
+        std::lock_guard<std::mutex> guard(registry_lock());
+        std::vector<vector_stats_entry> result;
+        for (const auto &r : registry()) {
+            const auto &c = *r.counters;
+            result.push_back(vector_stats_entry{
+                    r.type, r.tag, r.element_size,
+                    c.allocations.load(), c.bytes_allocated.load(), c.frees.load(), c.relocations.load(),
+                    c.elements_relocated.load(), c.bytes_relocated.load(), c.peak_capacity.load(),
+                    c.live_bytes.load(), c.wasted_bytes.load()});
+        }
+        return result;
+    }
+
+    void dump(std::ostream &out) {
+        for (const auto &e : snapshot()) {
+            out << e.type << ' ' << (e.tag.empty() ? "-" : e.tag)
+                << " allocations=" << e.allocations
+                << " bytes_allocated=" << e.bytes_allocated
+                << " frees=" << e.frees
+                << " relocations=" << e.relocations
+                << " elements_relocated=" << e.elements_relocated
+                << " bytes_relocated=" << e.bytes_relocated
+                << " peak_capacity=" << e.peak_capacity
+                << " live_bytes=" << e.live_bytes
+                << " wasted_bytes=" << e.wasted_bytes << '\n';
+        }
+    }
+
+    // live_bytes is left alone: those buffers are still allocated.
+    void reset() {
+        std::lock_guard<std::mutex> guard(registry_lock());
+        for (auto &r : registry()) {
+            auto &c = *r.counters;
+            c.allocations = c.bytes_allocated = c.frees = c.relocations = 0;
+            c.elements_relocated = c.bytes_relocated = 0;
+            c.peak_capacity = c.wasted_bytes = 0;
+        }
+    }
+}
@@ -0,0 +1,123 @@
+#ifndef VECTOR_VECTOR_STATS_H
+#define VECTOR_VECTOR_STATS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+#include <vector>
+
+// Counters shared by every vector with the same element type and call site tag.
+struct vector_counters {
+    std::atomic<std::uint64_t> allocations{0};
+    std::atomic<std::uint64_t> bytes_allocated{0};
+    std::atomic<std::uint64_t> frees{0};
+    // Reallocations that carried elements over, and how many elements/bytes they carried.
+    // realloc/mremap may have moved the bytes without copying them.
+    std::atomic<std::uint64_t> relocations{0};
+    std::atomic<std::uint64_t> elements_relocated{0};
+    std::atomic<std::uint64_t> bytes_relocated{0};
+    // Largest single buffer, in elements.
+    std::atomic<std::uint64_t> peak_capacity{0};
+    // Bytes of buffers currently allocated.
+    std::atomic<std::uint64_t> live_bytes{0};
+    // Unused capacity of buffers at the moment they were freed, summed up.
+    std::atomic<std::uint64_t> wasted_bytes{0};
+};
+
+struct vector_stats_entry {
+    std::string type;
+    std::string tag;
+    std::size_t element_size;
+    std::uint64_t allocations;
+    std::uint64_t bytes_allocated;
+    std::uint64_t frees;
+    std::uint64_t relocations;
+    std::uint64_t elements_relocated;
+    std::uint64_t bytes_relocated;
+    std::uint64_t peak_capacity;
+    std::uint64_t live_bytes;
+    std::uint64_t wasted_bytes;
+};
+
+// Registry of all counters created so far, for the metrics exporter.
+namespace vector_stats {
+    // The type is reported by its demangled name, the tag as it is.
+    vector_counters &register_counters(const std::type_info &type, const char *tag, std::size_t element_size);
+
+    // Readable form of a typeid name.
+    std::string demangle(const char *name);
+
+    std::vector<vector_stats_entry> snapshot();
+
+    // One line per element type and tag: `type tag key=value ...`.
+    void dump(std::ostream &out);
+
+    void reset();
+
+    template<typename Tag, typename = void>
+    struct tag_name {
+        static const char *get() {
+            static const std::string name = demangle(typeid(Tag).name());
+            return name.c_str();
+        }
+    };
+
+    template<typename Tag>
+    struct tag_name<Tag, decltype((void) Tag::name())> {
+        static const char *get() { return Tag::name(); }
+    };
+
+    template<>
+    struct tag_name<void, void> {
+        static const char *get() { return ""; }
+    };
+}
+
+// Instrumentation policy for vector. Tag names the call site: any type, and if it has a
+// static `const char *name()` that name is reported.
+//
+//     struct parse_site { static const char *name() { return "parse"; } };
+//     vector<int, default_growth, counting_stats<parse_site>> tokens;
+template<typename Tag = void>
+struct counting_stats {
+    template<typename T>
+    static vector_counters &counters() {
+        static vector_counters &c = vector_stats::register_counters(
+                typeid(T), vector_stats::tag_name<Tag>::get(), sizeof(T));
+        return c;
+    }
+
+    template<typename T>
+    static void allocated(std::size_t capacity) {
+        auto &c = counters<T>();
+        c.allocations.fetch_add(1, std::memory_order_relaxed);
+        c.bytes_allocated.fetch_add(capacity * sizeof(T), std::memory_order_relaxed);
+        c.live_bytes.fetch_add(capacity * sizeof(T), std::memory_order_relaxed);
+
+        std::uint64_t peak = c.peak_capacity.load(std::memory_order_relaxed);
+        while (peak < capacity && !c.peak_capacity.compare_exchange_weak(peak, capacity, std::memory_order_relaxed)) {
+        }
+    }
+
+    template<typename T>
+    static void freed(std::size_t used, std::size_t capacity) {
+        auto &c = counters<T>();
+        c.frees.fetch_add(1, std::memory_order_relaxed);
+        c.live_bytes.fetch_sub(capacity * sizeof(T), std::memory_order_relaxed);
+        c.wasted_bytes.fetch_add((capacity - used) * sizeof(T), std::memory_order_relaxed);
+    }
+
+    template<typename T>
+    static void relocated(std::size_t elements) {
+        auto &c = counters<T>();
+        c.relocations.fetch_add(1, std::memory_order_relaxed);
+        c.elements_relocated.fetch_add(elements, std::memory_order_relaxed);
+        c.bytes_relocated.fetch_add(elements * sizeof(T), std::memory_order_relaxed);
+    }
+};
+
+#endif //VECTOR_VECTOR_STATS_H